@@ -56,6 +56,8 @@
 #define U0RBR		*(volatile unsigned int *)0xE000C000
 #define U0DLL		*(volatile unsigned int *)0xE000C000
 #define U0DLM		*(volatile unsigned int *)0xE000C004
+#define U0IER		*(volatile unsigned int *)0xE000C004
+#define U0IIR		*(volatile unsigned int *)0xE000C008
 #define U0FCR		*(volatile unsigned int *)0xE000C008
 #define U0FDR		*(volatile unsigned int *)0xE000C028
 #define U0LCR		*(volatile unsigned int *)0xE000C00C
@@ -65,6 +67,8 @@
 #define U1RBR		*(volatile unsigned int *)0xE0010000
 #define U1DLL		*(volatile unsigned int *)0xE0010000
 #define U1DLM		*(volatile unsigned int *)0xE0010004
+#define U1IER		*(volatile unsigned int *)0xE0010004
+#define U1IIR		*(volatile unsigned int *)0xE0010008
 #define U1FCR		*(volatile unsigned int *)0xE0010008
 #define U1FDR		*(volatile unsigned int *)0xE0010028
 #define U1LCR		*(volatile unsigned int *)0xE001000C
@@ -94,6 +98,30 @@
 #define T0TCR                   *(volatile unsigned int *)0xE0004004
 #define T1TCR                   *(volatile unsigned int *)0xE0008004
 
+/* timer counter, prescale register and prescale counter */
+#define T0TC                    *(volatile unsigned int *)0xE0004008
+#define T1TC                    *(volatile unsigned int *)0xE0008008
+#define T0PR                    *(volatile unsigned int *)0xE000400C
+#define T1PR                    *(volatile unsigned int *)0xE000800C
+#define T0PC                    *(volatile unsigned int *)0xE0004010
+#define T1PC                    *(volatile unsigned int *)0xE0008010
+
+/* capture control and capture registers */
+#define T0CCR                   *(volatile unsigned int *)0xE0004028
+#define T1CCR                   *(volatile unsigned int *)0xE0008028
+#define T0CR0                   *(volatile unsigned int *)0xE000402C
+#define T1CR0                   *(volatile unsigned int *)0xE000802C
+#define T0CR1                   *(volatile unsigned int *)0xE0004030
+#define T1CR1                   *(volatile unsigned int *)0xE0008030
+#define T0CR2                   *(volatile unsigned int *)0xE0004034
+#define T1CR2                   *(volatile unsigned int *)0xE0008034
+#define T0CR3                   *(volatile unsigned int *)0xE0004038
+#define T1CR3                   *(volatile unsigned int *)0xE0008038
+
+/* external match */
+#define T0EMR                   *(volatile unsigned int *)0xE000403C
+#define T1EMR                   *(volatile unsigned int *)0xE000803C
+
 /* SPI0 (Serial Peripheral Interface 0) */
 #define S0SPCR			*(volatile unsigned int *)0xE0020000
 #define S0SPSR			*(volatile unsigned int *)0xE0020004
@@ -126,31 +154,31 @@
 
 /* Real Time Clock (RTC) */
 #define ILR          	        *(volatile unsigned int *)0xE0024000
-#define CTC                     *(volatile unsigned long *)0xE0024004
-#define CCR                     *(volatile unsigned long *)0xE0024008
-#define CIIR                    *(volatile unsigned long *)0xE002400C
-#define AMR                     *(volatile unsigned long *)0xE0024010
-#define CTIME0                  *(volatile unsigned long *)0xE0024014
-#define CTIME1                  *(volatile unsigned long *)0xE0024018
-#define CTIME2                  *(volatile unsigned long *)0xE002401C
-#define SEC                     *(volatile unsigned long *)0xE0024020
-#define MIN                     *(volatile unsigned long *)0xE0024024
-#define HOUR                    *(volatile unsigned long *)0xE0024028
-#define DOM                     *(volatile unsigned long *)0xE002402C
-#define DOW                     *(volatile unsigned long *)0xE0024030
-#define DOY                     *(volatile unsigned long *)0xE0024034
-#define MONTH                   *(volatile unsigned long *)0xE0024038
-#define YEAR                    *(volatile unsigned long *)0xE002403C
-#define ALSEC                   *(volatile unsigned long *)0xE0024060
-#define ALMIN                   *(volatile unsigned long *)0xE0024064
-#define ALHOUR                  *(volatile unsigned long *)0xE0024068
-#define ALDOM                   *(volatile unsigned long *)0xE002406C
-#define ALDOW                   *(volatile unsigned long *)0xE0024070
-#define ALDOY                   *(volatile unsigned long *)0xE0024074
-#define ALMON                   *(volatile unsigned long *)0xE0024078
-#define ALYEAR                  *(volatile unsigned long *)0xE002407C
-#define PREINT                  *(volatile unsigned long *)0xE0024080
-#define PREFRAC                 *(volatile unsigned long *)0xE0024084
+#define CTC                     *(volatile unsigned int *)0xE0024004
+#define CCR                     *(volatile unsigned int *)0xE0024008
+#define CIIR                    *(volatile unsigned int *)0xE002400C
+#define AMR                     *(volatile unsigned int *)0xE0024010
+#define CTIME0                  *(volatile unsigned int *)0xE0024014
+#define CTIME1                  *(volatile unsigned int *)0xE0024018
+#define CTIME2                  *(volatile unsigned int *)0xE002401C
+#define SEC                     *(volatile unsigned int *)0xE0024020
+#define MIN                     *(volatile unsigned int *)0xE0024024
+#define HOUR                    *(volatile unsigned int *)0xE0024028
+#define DOM                     *(volatile unsigned int *)0xE002402C
+#define DOW                     *(volatile unsigned int *)0xE0024030
+#define DOY                     *(volatile unsigned int *)0xE0024034
+#define MONTH                   *(volatile unsigned int *)0xE0024038
+#define YEAR                    *(volatile unsigned int *)0xE002403C
+#define ALSEC                   *(volatile unsigned int *)0xE0024060
+#define ALMIN                   *(volatile unsigned int *)0xE0024064
+#define ALHOUR                  *(volatile unsigned int *)0xE0024068
+#define ALDOM                   *(volatile unsigned int *)0xE002406C
+#define ALDOW                   *(volatile unsigned int *)0xE0024070
+#define ALDOY                   *(volatile unsigned int *)0xE0024074
+#define ALMON                   *(volatile unsigned int *)0xE0024078
+#define ALYEAR                  *(volatile unsigned int *)0xE002407C
+#define PREINT                  *(volatile unsigned int *)0xE0024080
+#define PREFRAC                 *(volatile unsigned int *)0xE0024084
 
 
 /* External Interrupts   */
@@ -160,6 +188,9 @@
 #define EXTPOLAR                *(volatile unsigned int *)0xE01FC14C
 
 /* Vectored Interrupt Controller */
+#define VICIRQStatus	        *(volatile unsigned int *)0xFFFFF000
+#define VICFIQStatus	        *(volatile unsigned int *)0xFFFFF004
+#define VICRawIntr	        *(volatile unsigned int *)0xFFFFF008
 #define VICIntSelect	        *(volatile unsigned int *)0xFFFFF00C
 #define VICIntEnable	        *(volatile unsigned int *)0xFFFFF010
 
@@ -168,6 +199,7 @@
 
 #define VICSoftInt              *(volatile unsigned int *)0xFFFFF018
 #define VICSoftIntClr           *(volatile unsigned int *)0xFFFFF01C
+#define VICProtection           *(volatile unsigned int *)0xFFFFF020
 
 
 
@@ -246,6 +278,24 @@
 #define IOCLR1			*(volatile unsigned int *)0xE002801C
 #define IO1CLR			*(volatile unsigned int *)0xE002801C
 
+/* System Control and Status: SCS_GPIOnM switches port n to the fast registers */
+#define SCS			*(volatile unsigned int *)0xE01FC1A0
+#define SCS_GPIO0M		(1<<0)
+#define SCS_GPIO1M		(1<<1)
+
+/* Fast GPIO, on the local bus. FIOnMASK bits set: the pin is left out of PIN, SET, CLR */
+#define FIO0DIR			*(volatile unsigned int *)0x3FFFC000
+#define FIO0MASK		*(volatile unsigned int *)0x3FFFC010
+#define FIO0PIN			*(volatile unsigned int *)0x3FFFC014
+#define FIO0SET			*(volatile unsigned int *)0x3FFFC018
+#define FIO0CLR			*(volatile unsigned int *)0x3FFFC01C
+
+#define FIO1DIR			*(volatile unsigned int *)0x3FFFC020
+#define FIO1MASK		*(volatile unsigned int *)0x3FFFC030
+#define FIO1PIN			*(volatile unsigned int *)0x3FFFC034
+#define FIO1SET			*(volatile unsigned int *)0x3FFFC038
+#define FIO1CLR			*(volatile unsigned int *)0x3FFFC03C
+
 /* PCONP bits */
 #define PCTIM0		(1<<1)
 #define PCTIM1		(1<<2)
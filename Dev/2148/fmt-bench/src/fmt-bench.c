@@ -0,0 +1,132 @@
+/*
+ * fmt-bench.c
+ * -------------------------
+ * Cycle counts of the integer formatters:
+ * the old one digit per '%' and '/' loop that
+ * printi and itoa used, against utoa_r.
+ *
+ * Timer0 counts PCLK with no prescale and
+ * hwSysInit sets APBDIV 1, so one tick is one
+ * CPU cycle.
+ */
+
+
+#include "./include/fmt-bench.h"
+
+
+#include "lpc214x.h"
+#include "types.h"
+#include "olimex.h"
+#include "helpers.h"
+#include "hwsys.h"
+#include "conio.h"
+#include "lpc-timer.h"
+
+typedef int (*conv_fn)(U32 val, char *buf, int base);
+
+static const U32 values[] = {
+    0, 7, 42, 1234, 65535, 1000000, 123456789, 0xFFFFFFFF
+};
+
+/*
+ * old_utoa
+ * ------------------------------
+ * the digit loop printi used before utoa_r.
+ */
+static int old_utoa(U32 u, char *buf, int base) {
+    char  tmp[12];
+    char *s = tmp + sizeof(tmp) - 1;
+    int   t, len = 0;
+
+    *s = '\0';
+    if (u == 0) *--s = '0';
+    while (u) {
+	t = u % base;
+	*--s = "0123456789abcdef"[t];
+	u /= base;
+    }
+    while ((*buf++ = *s++)) ++len;
+    return len;
+}
+
+/*
+ * null_conv
+ * ------------------------------
+ * call and loop overhead.
+ */
+static int null_conv(U32 u, char *buf, int base) {
+    return 0;
+}
+
+/*
+ * cycles
+ * ------------------------------
+ * average cycles of one f(val) call, without
+ * the loop and call overhead.
+ */
+static U32 cycles(conv_fn f, U32 val, int base, U32 overhead) {
+    char buf[ITOA_BUFLEN];
+    U32  start, end, n;
+
+    start = T0TC;
+    for (n = 0; n < BENCH_LOOPS; ++n) f(val, buf, base);
+    end   = T0TC;
+
+    end -= start;
+    return (end > overhead) ? (end - overhead) / BENCH_LOOPS : 0;
+}
+
+int main() {
+    U32 overhead, i, old_c, new_c;
+    int base;
+
+    initialize();
+
+    LED1_ON;
+    LED2_OFF;
+    printf("Hello: fmt-bench. cycles per call, %d calls each\n", BENCH_LOOPS);
+
+    overhead = cycles(null_conv, 0, 10, 0) * BENCH_LOOPS;
+
+    for (base = 10; base <= 16; base += 6) {
+	printf("\nbase %d\n%12s %8s %8s\n", base, "value", "old", "utoa_r");
+	for (i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+	    old_c = cycles(old_utoa, values[i], base, overhead);
+	    new_c = cycles(utoa_r,   values[i], base, overhead);
+	    printf("%12u %8u %8u\n", values[i], old_c, new_c);
+	}
+    }
+
+    printf("\ndone.\n");
+    LED2_ON;
+
+    while (1);
+
+    return(0);
+}
+
+
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * initialize the lpc2148 pll
+ * the uart0 serial port
+ * timer0 as a free running cycle counter
+ */
+void initialize(void)  {
+    // PLL and MAM, APBDIV 1: PCLK == CCLK
+    hwSysInit(SIXTY_MHZ);
+
+    // enable the leds
+    enable_leds();
+
+    console0Init(ONE_FIFTEEN_TWO_B);
+
+    // timer mode, no prescale, no match
+    SET_T0CTCR(0x0);
+    SET_PRESCALE0(0);
+    RESET_MATCH_CONTROL_0;
+    RESET_TIMER0;
+    ENABLE_TIMER0;
+}
@@ -0,0 +1,26 @@
+
+/*
+ * fmt-bench.h
+ */
+
+#ifndef _FMT_BENCH_H
+#define _FMT_BENCH_H
+
+
+#include "types.h"
+#include "lpc214x.h"
+
+// calls per measurement
+#define BENCH_LOOPS           1000
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * initialize the lpc2148 pll
+ * the uart0 serial port
+ * timer0 as a free running cycle counter
+ */
+void initialize(void);
+
+
+#endif
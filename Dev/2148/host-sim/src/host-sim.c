@@ -0,0 +1,534 @@
+/*
+ * host-sim.c
+ * -------------------------
+ * libs-lpc on the host against the register model in
+ * sim.c. Each check drives a driver the way a demo
+ * does and compares what the model saw, in simulated
+ * time, with what the hardware should do. The report
+ * goes out through the simulated UART0 to stdout; the
+ * exit status is the number of failed checks.
+ *
+ *   make && ./host-sim
+ */
+
+
+#include "./include/host-sim.h"
+#include "./include/sim.h"
+
+
+#include "lpc214x.h"
+#include "types.h"
+#include "helpers.h"
+#include "hwsys.h"
+#include "pll.h"
+#include "mam.h"
+#include "conio.h"
+#include "interrupts.h"
+#include "lpc-uart.h"
+#include "lpc-timer.h"
+#include "lpc-rtc.h"
+#include "lpc-gpio.h"
+#include "olimex.h"
+#include "timer-wheel.h"
+#include "defer.h"
+
+static U32 failed;
+
+// timer wheel delays, us
+static const U32 wheel_delays[] = { 1000, 2500, 5000, 40 };
+
+static volatile U32 rtc_ticks;
+static volatile U32 deferred;
+
+static swtimer_t wheel_t[sizeof(wheel_delays) / sizeof(wheel_delays[0])];
+static U64       wheel_due[sizeof(wheel_delays) / sizeof(wheel_delays[0])];
+static U64       wheel_fired[sizeof(wheel_delays) / sizeof(wheel_delays[0])];
+
+/*
+ * check
+ * ------------------------------
+ * one result line.
+ */
+static void check(bool ok, const char *what) {
+    printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+    if(!ok) ++failed;
+}
+
+// within TIME_TOLERANCE percent of expect, or TIME_SLACK_US
+static bool near(U64 got, U64 expect) {
+    U64 slack = MAXOF(expect * TIME_TOLERANCE / 100, TIME_SLACK_US);
+
+    return got + slack >= expect && got <= expect + slack;
+}
+
+static bool same(const char *a, const char *b) {
+    while(*a && *a == *b) { ++a; ++b; }
+    return *a == *b;
+}
+
+/*
+ * tx_idle
+ * ------------------------------
+ * Wait for the last char to leave the shift register.
+ */
+static void tx_idle(void) {
+    console0TxFlush();
+    while(!(U0LSR & LSR_TEMT));
+}
+
+/*
+ * uart_line_us
+ * ------------------------------
+ * Simulated us to send one LINE_CHARS line, from the
+ * first write until TEMT.
+ */
+static U32 uart_line_us(void) {
+    char line[LINE_CHARS];
+    U64  t0;
+    U32  k;
+
+    for(k = 0; k < LINE_CHARS - 2; ++k) line[k] = '.';
+    line[LINE_CHARS - 2] = '\r';
+    line[LINE_CHARS - 1] = '\n';
+
+    tx_idle();
+    t0 = sim_us();
+    uart_write(0, line, LINE_CHARS);
+    tx_idle();
+
+    return (U32) (sim_us() - t0);
+}
+
+static void check_uart(void) {
+    U32 line_us, expect_us, sent;
+    char buf[16];
+    line_t line;
+    uart_div_t div;
+
+    check(uart_baud_solve(60000000, 921600, &div) == 5 && div.dl == 3 &&
+          uart_baud_solve(60000000, UART_BAUD_MIN - 1, &div) > UART_BAUD_ERR_MAX,
+          "uart_baud_solve, too slow a rate rejected");
+
+    expect_us = LINE_CHARS * 10 * 1000000 / ONE_FIFTEEN_TWO_B;
+
+    line_us = uart_line_us();
+    printf("      polled:   %u us a line, %u expected\n", line_us, expect_us);
+    check(near(line_us, expect_us), "UART0 polled TX at 115200");
+
+    // polled chars still in the FIFO when buffering starts
+    tx_idle();
+    sim_uart_output(0, -1);
+    sent = sim_uart_sent(0);
+    uart_write(0, "0123456789abcdef", UART_FIFO_LEN);
+    console0TxBuffer(UART0_SLOT, TX_BLOCK);
+    uart_write(0, "0123456789abcdef", UART_FIFO_LEN);
+    tx_idle();
+    sent = sim_uart_sent(0) - sent;
+    sim_uart_output(0, 1);
+    check(sent == 2 * UART_FIFO_LEN, "UART0 polled to buffered TX, no chars lost");
+    tx_idle();
+
+    sent    = sim_uart_sent(0);
+    line_us = uart_line_us();
+    sent    = sim_uart_sent(0) - sent;
+    printf("      buffered: %u us a line, %u chars\n", line_us, sent);
+    check(near(line_us, expect_us) && sent == LINE_CHARS, "UART0 THRE interrupt TX");
+
+    console0RxBuffer(UART0_SLOT);
+    line_init(&line, buf, sizeof(buf));
+    sim_uart_rx(0, "hello sim\r");
+    check(serial_getline_nb(&line, 100) == 9 && same(buf, "hello sim"),
+          "UART0 RX interrupt, a line");
+}
+
+static void check_time(void) {
+    U64 t0;
+    U32 dt;
+
+    time_init(0);
+
+    t0 = sim_us();
+    delay_ms(20);
+    dt = (U32) (sim_us() - t0);
+    printf("      delay_ms(20): %u us\n", dt);
+    check(dt >= 20000 && near(dt, 20000), "time base delay_ms");
+
+    t0 = sim_us();
+    delay_us(250);
+    dt = (U32) (sim_us() - t0);
+    printf("      delay_us(250): %u us\n", dt);
+    check(dt >= 250 && near(dt, 250), "time base delay_us");
+
+    // 600 Hz: under 1 kHz, and ms are not whole ticks
+    time_init(99999);
+    t0 = sim_us();
+    delay_ms(5);
+    dt = (U32) (sim_us() - t0);
+    printf("      delay_ms(5) at 600 Hz: %u us\n", dt);
+    check(dt >= 5000, "time base delay_ms, slow rate");
+
+    time_init(0);
+}
+
+/*
+ * check_time_wrap
+ * ------------------------------
+ * 10 kHz ticks (prescale 5999): TC stays at 0xFFFFFFFF
+ * longer than a poll warps. From just short of the wrap,
+ * every read across it must move forward by a little,
+ * with the wrap ISR free to run between them.
+ */
+static void check_time_wrap(void) {
+    U64 prev, now;
+    bool ok = TRUE;
+
+    time_init(5999);
+    T1TC = 0xFFFFFFF8;
+
+    prev = time_now_cycles();
+    do {
+        // an access with IRQ on: the wrap ISR may run here
+        (void) T1TC;
+        now = time_now_cycles();
+        if(now < prev || now - prev > 16) ok = FALSE;
+        prev = now;
+    } while(ok && now < 0x100000008ULL);
+
+    printf("      across the wrap: 0x%x%08x\n", (U32) (now >> 32), (U32) now);
+    check(ok, "time base wrap, prescale 5999");
+
+    time_init(0);
+}
+
+static void wheel_cb(swtimer_t *t) {
+    wheel_fired[t->arg] = sim_us();
+}
+
+static void check_wheel(void) {
+    U32 k, n = sizeof(wheel_delays) / sizeof(wheel_delays[0]);
+    bool ok = TRUE;
+    U64 t0;
+
+    timer_wheel_init();
+
+    t0 = sim_us();
+    for(k = 0; k < n; ++k) {
+        wheel_t[k].arg = k;
+        wheel_due[k]   = t0 + wheel_delays[k];
+        timer_start(&wheel_t[k], wheel_delays[k], wheel_cb);
+    }
+    delay_ms(6);
+
+    for(k = 0; k < n; ++k) {
+        printf("      %5u us timer fired at %d us\n", wheel_delays[k],
+               (int) (wheel_fired[k] - t0));
+        if(wheel_fired[k] < wheel_due[k] ||
+           wheel_fired[k] > wheel_due[k] + WHEEL_SLACK_US) ok = FALSE;
+    }
+    check(ok, "timer0 match, timer wheel");
+}
+
+void RTC_Handler(void) __attribute__ ((interrupt("IRQ")));
+void RTC_Handler(void) {
+    ++rtc_ticks;
+    RESET_ILR;
+    EXIT_INTERRUPT;
+}
+
+static void check_rtc(void) {
+    U32 pclk = hwSysPclkVal(), preint = pclk / 32768 - 1;
+
+    rtc_init(SOURCE_PCLK);
+    rtc_prescale(preint, pclk - (preint + 1) * 32768);
+    rtc_setTime(58, 59, 23, 31, 12, 2009);
+    CIIR = 0x1;
+    rtc_ticks = 0;
+    enableRTC_INT(RTC_SLOT, (U32) RTC_Handler);
+
+    delay_ms(3500);
+    disableRTC_INT();
+
+    printf("      %u ticks, now %02u:%02u:%02u %u/%u/%u\n", rtc_ticks,
+           rtc_readHours(), rtc_readMins(), rtc_readSecs(),
+           rtc_readDom(), rtc_readMonth(), rtc_readYear());
+    check(rtc_ticks == 3 && rtc_readSecs() == 1 && rtc_readHours() == 0 &&
+          rtc_readDom() == 1 && rtc_readMonth() == 1 && rtc_readYear() == 2010,
+          "RTC seconds interrupt and rollover");
+}
+
+static void defer_cb(U32 arg) {
+    deferred = arg;
+}
+
+// nested handler on a forced channel: the F bit it ran with
+static volatile U32 nested_cpsr;
+
+static void nested_cb(void) {
+    nested_cpsr = host_cpsr;
+    vic_unforce(WATCHDOG_CHANNEL);
+}
+
+static void check_nested_fiq(void) {
+    bool ok;
+
+    irq_attach_nested(WATCHDOG_CHANNEL, (U32) nested_cb, 0);
+
+    disableFIQ();
+    nested_cpsr = 0;
+    vic_force(WATCHDOG_CHANNEL);
+    ok = (nested_cpsr & 0x1F) == 0x1F && (nested_cpsr & FIQ_MASK) &&
+         !(nested_cpsr & IRQ_MASK) && (host_cpsr & FIQ_MASK);
+    enableFIQ();
+
+    nested_cpsr = 0;
+    vic_force(WATCHDOG_CHANNEL);
+    ok = ok && (nested_cpsr & 0x1F) == 0x1F && !(nested_cpsr & INT_MASK);
+
+    irq_detach(WATCHDOG_CHANNEL);
+    check(ok, "nested IRQ handler, FIQ mask kept");
+}
+
+static volatile U32 fiq_calls;
+
+static void fiq_cb(void) __attribute__ ((interrupt("FIQ")));
+static void fiq_cb(void) {
+    ++fiq_calls;
+    vic_unforce(WATCHDOG_CHANNEL);
+}
+
+static void check_fiq(void) {
+    bool ok;
+
+    disableFIQ();
+    fiq_calls = 0;
+    fiq_attach(WATCHDOG_CHANNEL, (U32) fiq_cb);
+    vic_force(WATCHDOG_CHANNEL);
+    ok = fiq_calls == 0 && (host_cpsr & FIQ_MASK);
+
+    enableFIQ();
+    (void) VICRawIntr;
+    ok = ok && fiq_calls == 1;
+
+    // taken back as an IRQ: fiq_detach leaves it alone
+    irq_attach_nested(WATCHDOG_CHANNEL, (U32) nested_cb, 0);
+    fiq_detach();
+    nested_cpsr = 0;
+    vic_force(WATCHDOG_CHANNEL);
+    ok = ok && fiq_calls == 1 && nested_cpsr != 0;
+
+    irq_detach(WATCHDOG_CHANNEL);
+    check(ok, "fiq_attach leaves F to the caller, irq_attach takes it back");
+}
+
+static void check_defer(void) {
+    defer_init(DEFER_PRIORITY);
+    deferred = 0;
+    defer_post(defer_cb, 42);
+    check(deferred == 42, "VIC soft interrupt, defer_post");
+}
+
+/*
+ * check_memcpy_fast
+ * ------------------------------
+ * Every length to 40 at each alignment of dst and src,
+ * against a byte loop; the bytes around dst untouched.
+ */
+static void check_memcpy_fast(void) {
+    U8   src[48], dst[56];
+    U32  n, a, b, k;
+    bool ok = TRUE;
+
+    for(k = 0; k < sizeof(src); ++k) src[k] = (U8) (k * 37 + 1);
+
+    for(n = 0; n <= 40; ++n) {
+        for(a = 0; a < 4; ++a) {
+            for(b = 0; b < 4; ++b) {
+                for(k = 0; k < sizeof(dst); ++k) dst[k] = 0xA5;
+                if(memcpy_fast(dst + 4 + a, src + b, n) != dst + 4 + a) ok = FALSE;
+                for(k = 0; k < sizeof(dst); ++k) {
+                    if(k >= 4 + a && k < 4 + a + n) {
+                        if(dst[k] != src[b + k - 4 - a]) ok = FALSE;
+                    } else if(dst[k] != 0xA5) {
+                        ok = FALSE;
+                    }
+                }
+            }
+        }
+    }
+    check(ok, "memcpy_fast, lengths and alignments");
+}
+
+/*
+ * check_gpio
+ * ------------------------------
+ * Outputs set up through the legacy registers keep
+ * their direction and level over gpio_init, then the
+ * fast calls, the LEDs, and a legacy write that must
+ * no longer reach the port.
+ */
+static void check_gpio(void) {
+    U32 leds = (1 << LED1_INDEX) | (1 << LED2_INDEX), in = 1 << 15;
+    bool ok;
+
+    IO0DIR = leds | (1 << 20);
+    IO0SET = (1 << LED2_INDEX) | (1 << 20);
+    IO0CLR = (1 << LED1_INDEX);
+
+    gpio_init();
+    ok = sim_gpio_dir(0) == (leds | (1 << 20)) &&
+         (sim_gpio_pins(0) & (leds | (1 << 20))) == ((1 << LED2_INDEX) | (1 << 20));
+
+    gpio_clr(0, 1 << 20);
+    gpio_toggle(0, leds);
+    ok = ok && (sim_gpio_pins(0) & (leds | (1 << 20))) == (1 << LED1_INDEX);
+    gpio_write(0, leds, 1 << LED2_INDEX);
+    ok = ok && gpio_read(0, leds) == (1 << LED2_INDEX);
+
+    gpio_input(0, in);
+    sim_gpio_in(0, in);
+    ok = ok && gpio_read(0, in) == in;
+    sim_gpio_in(0, 0);
+    ok = ok && gpio_read(0, in) == 0;
+
+    enable_leds();
+    LED1_ON;
+    led2_invert();
+    ok = ok && (sim_gpio_pins(0) & leds) == 0;
+    IO0SET = leds;
+    ok = ok && (sim_gpio_pins(0) & leds) == 0;
+    led1_invert();
+    ok = ok && (sim_gpio_pins(0) & leds) == (1 << LED1_INDEX);
+
+    check(ok, "fast GPIO: gpio_init, set/clr/toggle/read, LEDs");
+}
+
+static void check_clock(void) {
+    static const freq_t freqs[] = {
+        TWELVE_MHZ, TWENTYFOUR_MHZ, THIRTYSIX_MHZ, FOURTYEIGHT_MHZ, SIXTY_MHZ
+    };
+    // hwSysInit's old table: PSEL, MSEL for each
+    static const U8 table[][2] = { { 3, 0 }, { 2, 1 }, { 2, 2 }, { 1, 3 }, { 1, 4 } };
+    pll_config_t cfg;
+    bool ok = TRUE;
+    U32  k;
+
+    for(k = 0; k < sizeof(freqs) / sizeof(freqs[0]); ++k) {
+        if(!pll0_solve(SIM_FOSC, freqs[k], freqs[k], &cfg) ||
+           cfg.psel != table[k][0] || cfg.msel != table[k][1] || cfg.apbdiv != 0x1) ok = FALSE;
+    }
+    check(ok, "pll0_solve, the freq_t points");
+
+    tx_idle();
+    ok = hwSysInitClock(SIM_FOSC, 30000000, 15000000);
+    console0Init(ONE_FIFTEEN_TWO_B);
+    printf("      30/15 MHz asked: CCLK %u PCLK %u MAMTIM %u\n", sim_cclk(),
+           hwSysPclkVal(), read_MAMTIM() & 0x7);
+    check(ok && sim_cclk() == 24000000 && hwSysCclkVal() == 24000000 &&
+          hwSysPclkVal() == 12000000 && (read_MAMTIM() & 0x7) == 2,
+          "hwSysInitClock, closest legal point");
+
+    tx_idle();
+    hwSysInit(SIXTY_MHZ);
+    console0Init(ONE_FIFTEEN_TWO_B);
+    check(sim_cclk() == 60000000 && (read_MAMTIM() & 0x7) == 3, "PLL0 back to 60 MHz");
+}
+
+/*
+ * freq_step
+ * ------------------------------
+ * hwSysSetFreq to cclk (PCLK = CCLK), then the time
+ * base against simulated time, a UART line, a wheel
+ * timer. FALSE on any miss.
+ */
+static bool freq_step(U32 cclk) {
+    U64 t0, us0;
+    U32 line_us, expect_us;
+    bool ok;
+
+    t0  = sim_us();
+    us0 = time_now_us();
+    ok  = hwSysSetFreq(cclk, cclk) && sim_cclk() == cclk && hwSysPclkVal() == (int) cclk;
+
+    // time base: the relock may slip it by the lock time
+    delay_ms(10);
+    printf("      %u MHz: time base %u us, simulated %u us\n", cclk / 1000000,
+           (U32) (time_now_us() - us0), (U32) (sim_us() - t0));
+    if(!near(time_now_us() - us0, sim_us() - t0)) ok = FALSE;
+
+    expect_us = LINE_CHARS * 10 * 1000000 / ONE_FIFTEEN_TWO_B;
+    line_us   = uart_line_us();
+    printf("      %u MHz: %u us a line\n", cclk / 1000000, line_us);
+    if(!near(line_us, expect_us)) ok = FALSE;
+
+    // the ISR runs after the access the match fell in: a
+    // poll can warp SIM_WARP_MAX CCLKs, 85 us at 12 MHz
+    wheel_fired[0] = 0;
+    t0 = sim_us();
+    timer_start(&wheel_t[0], 1000, wheel_cb);
+    delay_ms(2);
+    if(wheel_fired[0] < t0 + 1000 ||
+       wheel_fired[0] > t0 + 1000 + WHEEL_SLACK_US + SIM_WARP_MAX / (cclk / 1000000)) ok = FALSE;
+
+    if(PREINT != cclk / 32768 - 1 || PREFRAC != cclk % 32768) ok = FALSE;
+
+    return ok;
+}
+
+static void check_freq(void) {
+    bool ok;
+
+    // a tuned MAM mode, to be kept
+    write_MAM(0x1, read_MAMTIM() & 0x7);
+
+    ok = freq_step(12000000);
+    ok = freq_step(60000000) && ok;
+    check(ok && (read_MAMCR() & 0x3) == 0x1 && (read_MAMTIM() & 0x7) == 3,
+          "hwSysSetFreq 60-12-60 MHz, drivers retimed, MAM mode kept");
+}
+
+int main() {
+
+    initialize();
+
+    printf("Hello: host-sim. libs-lpc on the register model, CCLK %u Hz\n", sim_cclk());
+    check(sim_cclk() == 60000000 && hwSysPclkVal() == 60000000, "PLL0 60 MHz");
+
+    check_time();
+    check_time_wrap();
+    check_wheel();
+    check_rtc();
+    check_defer();
+    check_nested_fiq();
+    check_fiq();
+    check_uart();
+    check_memcpy_fast();
+    check_gpio();
+    check_clock();
+    check_freq();
+
+    printf("\ndone: %u failed, %u simulated us\n", failed, (U32) sim_us());
+    tx_idle();
+
+    return(failed);
+}
+
+
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * the register model, the lpc2148 pll
+ * the uart0 serial port (polled)
+ * IRQ on
+ */
+void initialize(void)  {
+    sim_init();
+
+    // PLL and MAM, APBDIV 1: PCLK == CCLK
+    hwSysInit(SIXTY_MHZ);
+
+    console0Init(ONE_FIFTEEN_TWO_B);
+
+    // crt.s would start main with IRQ disabled
+    enableIRQ();
+}
@@ -0,0 +1,41 @@
+
+/*
+ * host-sim.h
+ */
+
+#ifndef _HOST_SIM_H
+#define _HOST_SIM_H
+
+
+#include "types.h"
+#include "lpc214x.h"
+
+// U0LSR: transmitter empty, THR and shift register
+#define LSR_TEMT              0x40
+
+// VIC slots
+#define UART0_SLOT            1
+#define RTC_SLOT              2
+
+// chars of the UART throughput lines
+#define LINE_CHARS            64
+
+// how late a timer wheel callback may run, us
+#define WHEEL_SLACK_US        20
+
+// error allowed for a timed check: percent, and at least
+// the us a polled wait can overshoot (SIM_WARP_MAX CCLKs)
+#define TIME_TOLERANCE        2
+#define TIME_SLACK_US         20
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * the register model, the lpc2148 pll
+ * the uart0 serial port (polled)
+ * IRQ on
+ */
+void initialize(void);
+
+
+#endif
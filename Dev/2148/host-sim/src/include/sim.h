@@ -0,0 +1,141 @@
+
+/*
+ * sim.h
+ * -------------------------------------------
+ * Simulated LPC2148 register file for host (x86-64
+ * Linux) builds of libs-lpc.
+ *
+ * sim_init maps the APB peripherals (0xE0000000), the
+ * fast GPIO (0x3FFFC000) and the VIC (0xFFFFF000) at
+ * their real addresses with no access, so the
+ * lpc214x.h macros are used unchanged: every register
+ * access faults, the handler brings the register up to
+ * date, lets that one instruction run (trap flag) and
+ * then applies the write.
+ *
+ * Time is simulated CCLK cycles: SIM_ACCESS_CYCLES per
+ * register access, SIM_FIO_CYCLES for fast GPIO. A run
+ * of reads with no write (a poll loop) moves it faster,
+ * up to SIM_WARP_MAX a read, and code spinning on RAM
+ * (waiting for an ISR) gets SIM_IDLE_US every
+ * SIM_IDLE_CPU_US of host CPU time (not wall time:
+ * being descheduled is not idle).
+ *
+ * Modelled:
+ *   SCB     PLL0/PLL1 feed, lock and connect, APBDIV,
+ *           EXTINT (sim_eint raises a line)
+ *   timers  0 and 1: prescale, TC, MR0-3 interrupt,
+ *           reset and stop
+ *   UARTs   0 and 1: DLL/DLM/FDR char time, 16 byte
+ *           FIFOs, LSR, IER/IIR interrupts. TX goes to
+ *           a host fd, RX from sim_uart_rx
+ *   RTC     PCLK prescaler or 32 kHz source, the time
+ *           counters, CIIR and alarm interrupts
+ *   GPIO    ports 0 and 1, legacy registers until SCS
+ *           switches a port to FIO (mask, set, clear);
+ *           inputs from sim_gpio_in
+ *   VIC     vectored and default slots, priority masking
+ *           until VICVectAddr is written, soft ints, FIQ
+ * Any other register reads back what was written.
+ *
+ * Interrupts are taken after an access when host_cpsr
+ * (interrupts.c) allows: the address read from
+ * VICVectAddr is called as a function, as IRQ_Routine
+ * would jump to it.
+ *
+ * Build with -no-pie (handlers go in the VIC as U32)
+ * and -D'interrupt(x)='.
+ *
+ * Example:
+ *   sim_init();
+ *   hwSysInit(SIXTY_MHZ);
+ *   console0Init(ONE_FIFTEEN_TWO_B);
+ *   printf("hello\n");                  // on stdout
+ */
+
+#ifndef _SIM_H
+#define _SIM_H
+
+#include "types.h"
+
+// Olimex LPC-P2148 crystal
+#define SIM_FOSC               12000000
+
+// CCLKs per register access, a fast GPIO one, and the
+// poll loop warp
+#define SIM_ACCESS_CYCLES      4
+#define SIM_FIO_CYCLES         1
+#define SIM_WARP_AFTER         32
+#define SIM_WARP_MAX           1024
+
+// PLL lock time, CCLKs at FOSC
+#define SIM_PLL_LOCK_CYCLES    600
+
+// RAM spin: simulated time per host tick
+#define SIM_IDLE_CPU_US        200
+#define SIM_IDLE_US            1000
+
+#define SIM_UART_INLEN         1024
+
+/*
+ * sim_init
+ * ------------------------------
+ * Map the register pages, reset the models, install the
+ * signal handlers. Call first in main.
+ */
+void sim_init(void);
+
+/*
+ * sim_cycles / sim_us / sim_cclk
+ * ------------------------------
+ * Simulated CCLK cycles and microseconds since sim_init,
+ * the CCLK frequency now.
+ */
+U64  sim_cycles(void);
+U64  sim_us(void);
+U32  sim_cclk(void);
+
+/*
+ * sim_uart_rx
+ * ------------------------------
+ * Queue s on the RX pin of port (0 or 1): the chars
+ * arrive one char time apart. Returns the number
+ * queued, short when SIM_UART_INLEN is full.
+ */
+U32  sim_uart_rx(U8 port, const char *s);
+
+/*
+ * sim_uart_output
+ * ------------------------------
+ * Host fd that port's TX chars are written to, as each
+ * leaves the shift register: 1 for UART0 and 2 for
+ * UART1 by default, -1 drops them.
+ */
+void sim_uart_output(U8 port, int fd);
+
+/*
+ * sim_uart_sent
+ * ------------------------------
+ * Chars port has shifted out since sim_init.
+ */
+U32  sim_uart_sent(U8 port);
+
+/*
+ * sim_eint
+ * ------------------------------
+ * Edge on EINTn (0-3): sets the EXTINT flag.
+ */
+void sim_eint(U8 n);
+
+/*
+ * sim_gpio_in / sim_gpio_pins / sim_gpio_dir
+ * ------------------------------
+ * Drive the levels of port's (0 or 1) input pins; the
+ * levels on all its pins, outputs as driven; its
+ * direction register. No register access.
+ */
+void sim_gpio_in(U8 port, U32 pins);
+U32  sim_gpio_pins(U8 port);
+U32  sim_gpio_dir(U8 port);
+
+#endif
@@ -0,0 +1,1034 @@
+
+/*
+ * sim.c
+ * -------------------------------------------
+ * Simulated LPC2148 register file, see sim.h
+ *
+ * The mapped pages are only a window: the register
+ * values live in apb_reg / vic_reg and the models. A
+ * faulting access gets its one word filled in (reads),
+ * runs single stepped with the page open, and the word
+ * it left is handed to the model (writes).
+ */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include "./include/sim.h"
+
+#include "types.h"
+#include "hwsys.h"
+#include "interrupts.h"
+
+#define APB_BASE         0xE0000000
+#define APB_SIZE         0x00200000
+#define VIC_BASE         0xFFFFF000
+#define PAGE_SIZE        0x1000
+
+// APB peripherals sit on 16K boundaries
+#define APB_BLOCK        0x3FFF
+
+#define TIMER0_BASE      0xE0004000
+#define TIMER1_BASE      0xE0008000
+#define UART0_BASE       0xE000C000
+#define UART1_BASE       0xE0010000
+#define RTC_BASE         0xE0024000
+#define GPIO_BASE        0xE0028000
+#define SCB_BASE         0xE01FC000
+#define SCS_ADDR         (SCB_BASE + 0x1A0)
+#define FIO_BASE         0x3FFFC000
+
+#define PS_PER_S         1000000000000ULL
+#define EFL_TF           0x100
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE  MAP_FIXED
+#endif
+
+static U32 apb_reg[APB_SIZE / 4];
+static U32 vic_reg[PAGE_SIZE / 4];
+
+static U32 *shadow(U32 addr) {
+    if(addr >= VIC_BASE) return &vic_reg[(addr - VIC_BASE) >> 2];
+    return &apb_reg[(addr - APB_BASE) >> 2];
+}
+
+#define REG(a)           (*shadow(a))
+
+/*
+ * Clocks
+ * ------------------------------
+ */
+static U64 sim_cyc;                 // CCLKs
+static U64 sim_ps;                  // picoseconds
+static U64 sim_ps_rem;
+static U32 cclk_hz;
+static U32 apb_div;
+static U32 pclk_rem;
+
+typedef struct {
+    U32 base;                       // PLLnCON
+    U32 con;                        // fed CON and CFG
+    U32 cfg;
+    U64 lock_at;                    // sim_cyc
+} sim_pll_t;
+
+static sim_pll_t pll[2] = { { SCB_BASE + 0x80 }, { SCB_BASE + 0xA0 } };
+
+// the PLL whose feed saw 0xAA on the last access, or -1
+static int feed_armed = -1;
+static int feed_prev  = -1;
+
+static U32 eint_flags;
+
+static bool pll_locked(sim_pll_t *p) {
+    return (p->con & 0x1) && sim_cyc >= p->lock_at;
+}
+
+static U32 clock_cclk(void) {
+    if((pll[0].con & 0x3) == 0x3 && pll_locked(&pll[0]))
+        return SIM_FOSC * ((pll[0].cfg & 0x1F) + 1);
+    return SIM_FOSC;
+}
+
+static void pll_feed(sim_pll_t *p) {
+    U32 con = REG(p->base) & 0x3;
+    U32 cfg = REG(p->base + 0x4) & 0x7F;
+
+    if((con & 0x1) && (!(p->con & 0x1) || cfg != p->cfg))
+        p->lock_at = sim_cyc + SIM_PLL_LOCK_CYCLES;
+    p->con = con;
+    p->cfg = cfg;
+}
+
+static U32 scb_read(U32 addr) {
+    U32 off = addr & APB_BLOCK;
+    sim_pll_t *p;
+
+    if(off == 0x088 || off == 0x0A8) {
+        p = &pll[off == 0x0A8];
+        return p->cfg | ((p->con & 0x3) << 8) | (pll_locked(p) << 10);
+    }
+    if(off == 0x140) return eint_flags;
+    return REG(addr);
+}
+
+static void scb_write(U32 addr, U32 v) {
+    U32 off = addr & APB_BLOCK;
+    int n;
+
+    switch(off) {
+        case 0x08C:
+        case 0x0AC:
+            n = (off == 0x0AC);
+            if(v == 0xAA)                         feed_armed = n;
+            else if(v == 0x55 && feed_prev == n)  pll_feed(&pll[n]);
+            break;
+        case 0x100:
+            if((v & 0x3) != 0x3) {
+                apb_div  = (v & 0x3) ? (v & 0x3) : 4;
+                REG(addr) = v & 0x3;
+            }
+            break;
+        case 0x140:
+            eint_flags &= ~v;
+            break;
+        default:
+            REG(addr) = v;
+            break;
+    }
+}
+
+/*
+ * Timers
+ * ------------------------------
+ * Per TC increment: reset on a match of the old TC,
+ * then interrupt and stop on a match of the new one,
+ * so with reset on MRn the period is MRn + 1.
+ */
+typedef struct {
+    U32 base;
+    U32 ir;
+    U32 tc;
+    U32 pc;
+} sim_timer_t;
+
+static sim_timer_t timer[2] = { { TIMER0_BASE }, { TIMER1_BASE } };
+
+static void timer_advance(sim_timer_t *t, U32 pclks) {
+    U32 mcr, next, act, k;
+    U64 total, incs, skip;
+
+    if((REG(t->base + 0x04) & 0x3) != 0x1 || (REG(t->base + 0x70) & 0x3)) return;
+
+    total  = (U64) t->pc + pclks;
+    incs   = total / ((U64) REG(t->base + 0x0C) + 1);
+    t->pc  = total % ((U64) REG(t->base + 0x0C) + 1);
+
+    mcr = REG(t->base + 0x14) & 0xFFF;
+    if(mcr == 0) {
+        t->tc += (U32) incs;
+        return;
+    }
+
+    while(incs) {
+        // increments that reach no match register go in one step
+        skip = incs;
+        for(k = 0; k < 4; ++k) {
+            if(!((mcr >> (3 * k)) & 0x7)) continue;
+            next = REG(t->base + 0x18 + 4 * k) - t->tc;
+            if(next == 0)             skip = 0;
+            else if(next - 1 < skip)  skip = next - 1;
+        }
+        t->tc += (U32) skip;
+        incs  -= skip;
+        if(incs-- == 0) break;
+
+        next = t->tc + 1;
+        for(k = 0; k < 4; ++k) {
+            if(((mcr >> (3 * k)) & 0x2) && t->tc == REG(t->base + 0x18 + 4 * k)) next = 0;
+        }
+        t->tc = next;
+
+        for(k = 0; k < 4; ++k) {
+            act = (mcr >> (3 * k)) & 0x7;
+            if(act == 0 || t->tc != REG(t->base + 0x18 + 4 * k)) continue;
+            if(act & 0x1) t->ir |= (1 << k);
+            if(act & 0x4) {
+                REG(t->base + 0x04) &= ~0x1;
+                t->pc = 0;
+                return;
+            }
+        }
+    }
+}
+
+static U32 timer_read(sim_timer_t *t, U32 addr) {
+    switch(addr & APB_BLOCK) {
+        case 0x00: return t->ir;
+        case 0x08: return t->tc;
+        case 0x10: return t->pc;
+        default:   return REG(addr);
+    }
+}
+
+static void timer_write(sim_timer_t *t, U32 addr, U32 v) {
+    switch(addr & APB_BLOCK) {
+        case 0x00: t->ir &= ~v;  break;
+        case 0x08: t->tc  = v;   break;
+        case 0x10: t->pc  = v;   break;
+        case 0x04:
+            if(v & 0x2) t->tc = t->pc = 0;
+            REG(addr) = v & 0x3;
+            break;
+        default:
+            REG(addr) = v;
+            break;
+    }
+}
+
+/*
+ * UARTs
+ * ------------------------------
+ * A char takes 16 * DL * bits * (MULVAL + DIVADDVAL) /
+ * MULVAL PCLKs. The THRE interrupt is raised when the
+ * TX FIFO empties into the shift register and cleared
+ * by a THR write or an IIR read that reports it.
+ */
+typedef struct {
+    U32 base;
+    int fd;
+    U32 dll, dlm, ier, fcr;
+    U8  tx[16];
+    U8  tx_n, tx_h;
+    U8  tsr;
+    bool tsr_busy;
+    U32 tsr_left;                   // PCLKs
+    U8  rx[16];
+    U8  rx_n, rx_h;
+    U32 rx_idle;                    // PCLKs since the RX FIFO moved
+    U8  in[SIM_UART_INLEN];
+    U32 in_n, in_h;
+    U32 in_left;                    // PCLKs to the next RX char
+    bool thre;
+    bool oe;
+    U32 sent;
+} sim_uart_t;
+
+static sim_uart_t uart[2] = { { UART0_BASE, 1 }, { UART1_BASE, 2 } };
+
+static const U8 uart_trigger[4] = { 1, 4, 8, 14 };
+
+static U32 uart_char_time(sim_uart_t *u) {
+    U32 lcr  = REG(u->base + 0x0C);
+    U32 fdr  = REG(u->base + 0x28);
+    U32 dl   = (u->dlm << 8) | u->dll;
+    U32 mul  = (fdr >> 4) & 0xF;
+    U32 bits = 1 + 5 + (lcr & 0x3) + ((lcr & 0x4) ? 2 : 1) + ((lcr & 0x8) ? 1 : 0);
+
+    if(dl == 0)  dl  = 1;
+    if(mul == 0) mul = 1;
+
+    return (U32) ((U64) 16 * dl * bits * (mul + (fdr & 0xF)) / mul);
+}
+
+// TX FIFO to the shift register when that is free
+static void uart_load(sim_uart_t *u) {
+    if(u->tsr_busy || u->tx_n == 0) return;
+
+    u->tsr      = u->tx[u->tx_h];
+    u->tx_h     = (u->tx_h + 1) & 0xF;
+    u->tsr_busy = TRUE;
+    u->tsr_left = uart_char_time(u);
+    if(--u->tx_n == 0) u->thre = TRUE;
+}
+
+static void uart_advance(sim_uart_t *u, U32 pclks) {
+    U32 p = pclks;
+
+    while(u->tsr_busy) {
+        if(p < u->tsr_left) {
+            u->tsr_left -= p;
+            break;
+        }
+        p -= u->tsr_left;
+        if(u->fd >= 0 && write(u->fd, &u->tsr, 1) < 0) u->fd = -1;
+        ++u->sent;
+        u->tsr_busy = FALSE;
+        uart_load(u);
+    }
+
+    p = pclks;
+    if(u->rx_n && u->rx_idle < 0x80000000) u->rx_idle += p;
+    while(u->in_n) {
+        if(p < u->in_left) {
+            u->in_left -= p;
+            break;
+        }
+        p -= u->in_left;
+        if(u->rx_n < 16) {
+            u->rx[(u->rx_h + u->rx_n) & 0xF] = u->in[u->in_h];
+            ++u->rx_n;
+        } else {
+            u->oe = TRUE;
+        }
+        u->in_h    = (u->in_h + 1) % SIM_UART_INLEN;
+        --u->in_n;
+        u->rx_idle = p;
+        u->in_left = uart_char_time(u);
+    }
+}
+
+static U32 uart_iir(sim_uart_t *u) {
+    U32 fifo = (u->fcr & 0x1) ? 0xC0 : 0;
+
+    if((u->ier & 0x4) && u->oe)                                 return fifo | 0x6;
+    if((u->ier & 0x1) && u->rx_n >= uart_trigger[u->fcr >> 6])  return fifo | 0x4;
+    if((u->ier & 0x1) && u->rx_n && u->rx_idle >= 4 * uart_char_time(u))
+                                                                return fifo | 0xC;
+    if((u->ier & 0x2) && u->thre)                               return fifo | 0x2;
+    return fifo | 0x1;
+}
+
+static U32 uart_read(sim_uart_t *u, U32 addr, bool side) {
+    bool dlab = (REG(u->base + 0x0C) & 0x80) != 0;
+    U32  v;
+
+    switch(addr & APB_BLOCK) {
+        case 0x00:
+            if(dlab) return u->dll;
+            if(u->rx_n == 0) return REG(addr);
+            v = u->rx[u->rx_h];
+            if(side) {
+                u->rx_h    = (u->rx_h + 1) & 0xF;
+                u->rx_idle = 0;
+                --u->rx_n;
+                REG(addr)  = v;
+            }
+            return v;
+        case 0x04:
+            return dlab ? u->dlm : u->ier;
+        case 0x08:
+            v = uart_iir(u);
+            if(side && (v & 0xF) == 0x2) u->thre = FALSE;
+            return v;
+        case 0x14:
+            v = (u->rx_n ? 0x01 : 0) | (u->oe ? 0x02 : 0);
+            if(u->tx_n == 0)                 v |= 0x20;
+            if(u->tx_n == 0 && !u->tsr_busy) v |= 0x40;
+            if(side) u->oe = FALSE;
+            return v;
+        default:
+            return REG(addr);
+    }
+}
+
+static void uart_write(sim_uart_t *u, U32 addr, U32 v) {
+    bool dlab = (REG(u->base + 0x0C) & 0x80) != 0;
+
+    switch(addr & APB_BLOCK) {
+        case 0x00:
+            if(dlab) {
+                u->dll = v & 0xFF;
+                break;
+            }
+            if(u->tx_n < 16) {
+                u->tx[(u->tx_h + u->tx_n) & 0xF] = v;
+                ++u->tx_n;
+            }
+            u->thre = FALSE;
+            uart_load(u);
+            break;
+        case 0x04:
+            if(dlab) u->dlm = v & 0xFF;
+            else     u->ier = v & 0x7;
+            break;
+        case 0x08:
+            u->fcr = v & 0xC1;
+            if(v & 0x2) u->rx_n = 0;
+            if(v & 0x4) u->tx_n = 0;
+            break;
+        case 0x14:
+            break;
+        default:
+            REG(addr) = v;
+            break;
+    }
+}
+
+/*
+ * RTC
+ * ------------------------------
+ * 32 kHz ticks from the PCLK prescaler, a tick every
+ * PREINT + 1 + PREFRAC / 32768 PCLKs, or from simulated
+ * time with CLKSRC set. The time counters are the
+ * registers software writes.
+ */
+#define RTC_REG(off)     REG(RTC_BASE + (off))
+
+static U32 rtc_ilr;
+static U32 rtc_ctc;                 // 32 kHz ticks into the second
+static U64 rtc_acc;
+
+static const U8 rtc_mdays[13] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+static void rtc_second(void) {
+    U32 inc = 0x01, year = RTC_REG(0x3C), mon = RTC_REG(0x38), k, mdays;
+
+    if(++RTC_REG(0x20) > 59) {
+        RTC_REG(0x20) = 0;
+        inc |= 0x02;
+        if(++RTC_REG(0x24) > 59) {
+            RTC_REG(0x24) = 0;
+            inc |= 0x04;
+            if(++RTC_REG(0x28) > 23) {
+                RTC_REG(0x28) = 0;
+                inc |= 0x38;
+                RTC_REG(0x30) = (RTC_REG(0x30) + 1) % 7;
+                ++RTC_REG(0x34);
+
+                mdays = (mon >= 1 && mon <= 12) ? rtc_mdays[mon] : 31;
+                if(mon == 2 && (year & 0x3) == 0) ++mdays;
+                if(++RTC_REG(0x2C) > mdays) {
+                    RTC_REG(0x2C) = 1;
+                    inc |= 0x40;
+                    if(++RTC_REG(0x38) > 12) {
+                        RTC_REG(0x38) = 1;
+                        RTC_REG(0x34) = 1;
+                        ++RTC_REG(0x3C);
+                        inc |= 0x80;
+                    }
+                }
+            }
+        }
+    }
+
+    if(RTC_REG(0x0C) & inc) rtc_ilr |= 0x1;
+
+    // alarm: every unmasked field equal
+    if((RTC_REG(0x10) & 0xFF) == 0xFF) return;
+    for(k = 0; k < 8; ++k) {
+        if(!(RTC_REG(0x10) & (1 << k)) && RTC_REG(0x20 + 4 * k) != RTC_REG(0x60 + 4 * k)) return;
+    }
+    rtc_ilr |= 0x2;
+}
+
+static void rtc_advance(U32 pclks, U64 ps) {
+    U32 ccr = RTC_REG(0x08), per;
+    U64 n;
+
+    if((ccr & 0x3) != 0x1) return;
+
+    if(ccr & 0x10) {
+        rtc_acc += ps * 32768;
+        n        = rtc_acc / PS_PER_S;
+        rtc_acc %= PS_PER_S;
+    } else {
+        if((RTC_REG(0x80) & 0x1FFF) == 0) return;
+        per      = ((RTC_REG(0x80) & 0x1FFF) + 1) * 32768 + (RTC_REG(0x84) & 0x7FFF);
+        rtc_acc += (U64) pclks * 32768;
+        n        = rtc_acc / per;
+        rtc_acc %= per;
+    }
+
+    n += rtc_ctc;
+    while(n >= 32768) {
+        n -= 32768;
+        rtc_second();
+    }
+    rtc_ctc = (U32) n;
+}
+
+static U32 rtc_read(U32 addr) {
+    switch(addr & APB_BLOCK) {
+        case 0x00: return rtc_ilr;
+        case 0x04: return (rtc_ctc & 0x7FFF) << 1;
+        case 0x14: return RTC_REG(0x20) | (RTC_REG(0x24) << 8) | (RTC_REG(0x28) << 16) | (RTC_REG(0x30) << 24);
+        case 0x18: return RTC_REG(0x2C) | (RTC_REG(0x38) << 8) | (RTC_REG(0x3C) << 16);
+        case 0x1C: return RTC_REG(0x34);
+        default:   return REG(addr);
+    }
+}
+
+static void rtc_write(U32 addr, U32 v) {
+    switch(addr & APB_BLOCK) {
+        case 0x00:
+            rtc_ilr &= ~v;
+            break;
+        case 0x08:
+            if((v ^ REG(addr)) & 0x10) rtc_acc = 0;
+            if(v & 0x2) rtc_ctc = 0;
+            REG(addr) = v & 0x13;
+            break;
+        case 0x04:
+        case 0x14:
+        case 0x18:
+        case 0x1C:
+            break;
+        default:
+            REG(addr) = v;
+            break;
+    }
+}
+
+/*
+ * GPIO
+ * ------------------------------
+ * Ports 0 and 1: a direction and an output latch each,
+ * written through the legacy APB registers or, with
+ * the port's SCS bit set, through the fast ones only
+ * (FIOnMASK applies). Pins that are inputs read
+ * gpio_in. Word accesses only.
+ */
+static U32 gpio_dir[2];
+static U32 gpio_out[2];
+static U32 gpio_mask[2];
+static U32 gpio_in[2];
+
+static bool gpio_fast(U32 n) {
+    return (REG(SCS_ADDR) >> n) & 0x1;
+}
+
+static U32 gpio_pins(U32 n) {
+    return (gpio_out[n] & gpio_dir[n]) | (gpio_in[n] & ~gpio_dir[n]);
+}
+
+static U32 gpio_read(U32 addr) {
+    U32 n = (addr >> 4) & 0x1;
+
+    switch(addr & 0xC) {
+        case 0x0: return gpio_pins(n);
+        case 0x4: return gpio_out[n];
+        case 0x8: return gpio_dir[n];
+        default:  return 0;
+    }
+}
+
+static void gpio_write(U32 addr, U32 v) {
+    U32 n = (addr >> 4) & 0x1;
+
+    if(gpio_fast(n)) return;
+
+    switch(addr & 0xC) {
+        case 0x4: gpio_out[n] |=  v; break;
+        case 0x8: gpio_dir[n]  =  v; break;
+        case 0xC: gpio_out[n] &= ~v; break;
+        default:                     break;
+    }
+}
+
+static U32 fio_read(U32 addr) {
+    U32 n = (addr >> 5) & 0x1;
+
+    if(!gpio_fast(n)) return 0;
+
+    switch(addr & 0x1F) {
+        case 0x00: return gpio_dir[n];
+        case 0x10: return gpio_mask[n];
+        case 0x14: return gpio_pins(n) & ~gpio_mask[n];
+        case 0x18: return gpio_out[n] & ~gpio_mask[n];
+        default:   return 0;
+    }
+}
+
+static void fio_write(U32 addr, U32 v) {
+    U32 n = (addr >> 5) & 0x1, m = ~gpio_mask[n];
+
+    if(!gpio_fast(n)) return;
+
+    switch(addr & 0x1F) {
+        case 0x00: gpio_dir[n]  = v;                                break;
+        case 0x10: gpio_mask[n] = v;                                break;
+        case 0x14: gpio_out[n]  = (gpio_out[n] & ~m) | (v & m);    break;
+        case 0x18: gpio_out[n] |= v & m;                            break;
+        case 0x1C: gpio_out[n] &= ~(v & m);                         break;
+        default:                                                    break;
+    }
+}
+
+/*
+ * VIC
+ * ------------------------------
+ * Reading VICVectAddr puts the slot (16 for the default
+ * vector) in service, masking it and every lower
+ * priority until VICVectAddr is written.
+ */
+#define VIC_REG(off)     vic_reg[(off) >> 2]
+#define VIC_NONE         17
+
+static U32 vic_en;
+static U32 vic_soft;
+static U8  vic_stack[VIC_NONE];
+static U32 vic_sp;
+
+static U32 vic_raw(void) {
+    U32 raw = vic_soft | ((eint_flags & 0xF) << VIC_EINT0);
+
+    if(timer[0].ir)                 raw |= (1 << VIC_TIMER0);
+    if(timer[1].ir)                 raw |= (1 << VIC_TIMER1);
+    if(!(uart_iir(&uart[0]) & 0x1)) raw |= (1 << VIC_UART0);
+    if(!(uart_iir(&uart[1]) & 0x1)) raw |= (1 << VIC_UART1);
+    if(rtc_ilr & 0x3)               raw |= (1 << VIC_RTC);
+
+    return raw;
+}
+
+static U32 vic_pick(U32 irq) {
+    U32 s, cntl;
+
+    for(s = 0; s < 16; ++s) {
+        cntl = VIC_REG(0x200 + 4 * s);
+        if((cntl & 0x20) && (irq & (1 << (cntl & 0x1F)))) return s;
+    }
+    return irq ? 16 : VIC_NONE;
+}
+
+static U32 vic_top(void) {
+    return vic_sp ? vic_stack[vic_sp - 1] : VIC_NONE;
+}
+
+static U32 vic_vector(U32 s) {
+    if(s >= vic_top() || s == VIC_NONE) return VIC_REG(0x034);
+
+    vic_stack[vic_sp++] = s;
+    return (s < 16) ? VIC_REG(0x100 + 4 * s) : VIC_REG(0x034);
+}
+
+static U32 vic_read(U32 addr, bool side) {
+    U32 off = addr - VIC_BASE, raw = vic_raw(), sel = VIC_REG(0x00C);
+
+    switch(off) {
+        case 0x000: return raw & vic_en & ~sel;
+        case 0x004: return raw & vic_en & sel;
+        case 0x008: return raw;
+        case 0x010: return vic_en;
+        case 0x018: return vic_soft;
+        case 0x030:
+            if(!side) return VIC_REG(off);
+            return vic_vector(vic_pick(raw & vic_en & ~sel));
+        default:    return VIC_REG(off);
+    }
+}
+
+static void vic_write(U32 addr, U32 v) {
+    U32 off = addr - VIC_BASE;
+
+    switch(off) {
+        case 0x010: vic_en   |=  v; break;
+        case 0x014: vic_en   &= ~v; break;
+        case 0x018: vic_soft |=  v; break;
+        case 0x01C: vic_soft &= ~v; break;
+        case 0x030: if(vic_sp) --vic_sp; break;
+        case 0x000:
+        case 0x004:
+        case 0x008:
+            break;
+        default:    VIC_REG(off) = v; break;
+    }
+}
+
+/*
+ * Time
+ * ------------------------------
+ */
+static void sim_advance(U32 cycles) {
+    U64 ps0 = sim_ps;
+    U32 pclks;
+
+    sim_cyc    += cycles;
+    sim_ps_rem += (U64) cycles * PS_PER_S;
+    sim_ps     += sim_ps_rem / cclk_hz;
+    sim_ps_rem %= cclk_hz;
+
+    pclk_rem += cycles;
+    pclks     = pclk_rem / apb_div;
+    pclk_rem %= apb_div;
+
+    timer_advance(&timer[0], pclks);
+    timer_advance(&timer[1], pclks);
+    uart_advance(&uart[0], pclks);
+    uart_advance(&uart[1], pclks);
+    rtc_advance(pclks, sim_ps - ps0);
+
+    cclk_hz = clock_cclk();
+}
+
+/*
+ * Register access
+ * ------------------------------
+ * side is FALSE for the read before a write: the old
+ * value, without popping a FIFO or clearing a flag.
+ */
+static U32 reg_read(U32 addr, bool side) {
+    if(addr >= VIC_BASE) return vic_read(addr, side);
+    if(addr <  APB_BASE) return fio_read(addr);
+
+    switch(addr & ~APB_BLOCK) {
+        case TIMER0_BASE: return timer_read(&timer[0], addr);
+        case TIMER1_BASE: return timer_read(&timer[1], addr);
+        case UART0_BASE:  return uart_read(&uart[0], addr, side);
+        case UART1_BASE:  return uart_read(&uart[1], addr, side);
+        case RTC_BASE:    return rtc_read(addr);
+        case GPIO_BASE:   return gpio_read(addr);
+        case SCB_BASE:    return scb_read(addr);
+        default:          return REG(addr);
+    }
+}
+
+static void reg_write(U32 addr, U32 v) {
+    if(addr >= VIC_BASE) {
+        vic_write(addr, v);
+        return;
+    }
+    if(addr < APB_BASE) {
+        fio_write(addr, v);
+        return;
+    }
+
+    switch(addr & ~APB_BLOCK) {
+        case TIMER0_BASE: timer_write(&timer[0], addr, v); break;
+        case TIMER1_BASE: timer_write(&timer[1], addr, v); break;
+        case UART0_BASE:  uart_write(&uart[0], addr, v);   break;
+        case UART1_BASE:  uart_write(&uart[1], addr, v);   break;
+        case RTC_BASE:    rtc_write(addr, v);              break;
+        case GPIO_BASE:   gpio_write(addr, v);             break;
+        case SCB_BASE:    scb_write(addr, v);              break;
+        default:          REG(addr) = v;                   break;
+    }
+}
+
+/*
+ * Interrupt delivery
+ * ------------------------------
+ * After each access and idle step: FIQ unless F is set,
+ * then the VIC's pick unless I is set or a slot of
+ * higher or equal priority is in service.
+ */
+static void sim_fatal(const char *msg) {
+    if(write(2, msg, strlen(msg)) < 0) _exit(2);
+    abort();
+}
+
+static void sim_deliver(void) {
+    U32 raw, cpsr, s, handler;
+
+    for(;;) {
+        raw  = vic_raw() & vic_en;
+        cpsr = host_cpsr;
+
+        if(!(cpsr & FIQ_MASK) && (raw & VIC_REG(0x00C))) {
+            host_cpsr = (cpsr & ~0x1F) | INT_MASK | 0x11;
+            FIQ_Routine();
+            host_cpsr = cpsr;
+            continue;
+        }
+        if(cpsr & IRQ_MASK) return;
+
+        s = vic_pick(raw & ~VIC_REG(0x00C));
+        if(s >= vic_top()) return;
+
+        handler = vic_vector(s);
+        if(handler == 0) sim_fatal("sim: IRQ with no handler in the VIC\n");
+
+        host_cpsr = (cpsr & ~0x1F) | IRQ_MASK | 0x12;
+        ((void (*)(void)) (uintptr_t) handler)();
+        host_cpsr = cpsr;
+    }
+}
+
+/*
+ * Fault and trap handlers
+ * ------------------------------
+ */
+static volatile bool sim_busy;
+static volatile U32  sim_accesses;
+static U32           sim_reads;             // in a row
+static U32           acc_addr;
+static bool          acc_write;
+static int           acc_vtalrm;
+
+static bool sim_owns(U32 addr) {
+    return (addr >= APB_BASE && addr < APB_BASE + APB_SIZE) || addr >= VIC_BASE ||
+           (addr >= FIO_BASE && addr < FIO_BASE + PAGE_SIZE);
+}
+
+static void sim_step(bool write, U32 n) {
+
+    ++sim_accesses;
+    feed_prev  = feed_armed;
+    feed_armed = -1;
+
+    if(write) {
+        sim_reads = 0;
+    } else if(++sim_reads > SIM_WARP_AFTER) {
+        n *= sim_reads - SIM_WARP_AFTER + 1;
+        if(n > SIM_WARP_MAX) n = SIM_WARP_MAX;
+    }
+    sim_advance(n);
+}
+
+static void sim_segv(int sig, siginfo_t *si, void *ctx) {
+    ucontext_t *uc = (ucontext_t *) ctx;
+    uintptr_t   a  = (uintptr_t) si->si_addr;
+
+    if(a > 0xFFFFFFFF || !sim_owns((U32) a) || sim_busy) {
+        // not a register: fault again, for real
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    acc_addr  = (U32) a & ~0x3;
+    acc_write = (uc->uc_mcontext.gregs[REG_ERR] & 0x2) != 0;
+    sim_busy  = TRUE;
+
+    sim_step(acc_write, (acc_addr < APB_BASE) ? SIM_FIO_CYCLES : SIM_ACCESS_CYCLES);
+
+    mprotect((void *) (uintptr_t) (acc_addr & ~(PAGE_SIZE - 1)), PAGE_SIZE, PROT_READ | PROT_WRITE);
+    *(volatile U32 *) (uintptr_t) acc_addr = reg_read(acc_addr, !acc_write);
+
+    uc->uc_mcontext.gregs[REG_EFL] |= EFL_TF;
+    acc_vtalrm = sigismember(&uc->uc_sigmask, SIGVTALRM);
+    sigaddset(&uc->uc_sigmask, SIGVTALRM);
+}
+
+static void sim_trap(int sig, siginfo_t *si, void *ctx) {
+    ucontext_t *uc = (ucontext_t *) ctx;
+
+    uc->uc_mcontext.gregs[REG_EFL] &= ~EFL_TF;
+    if(!sim_busy) return;
+    if(!acc_vtalrm) sigdelset(&uc->uc_sigmask, SIGVTALRM);
+
+    if(acc_write) reg_write(acc_addr, *(volatile U32 *) (uintptr_t) acc_addr);
+
+    mprotect((void *) (uintptr_t) (acc_addr & ~(PAGE_SIZE - 1)), PAGE_SIZE, PROT_NONE);
+    sim_busy = FALSE;
+
+    sim_deliver();
+}
+
+// I or F cleared: take what is pending, unless mid access.
+// From main, not a handler: keep the idle tick out
+static volatile bool sim_unmasking;
+
+static void sim_unmask(void) {
+    if(sim_busy || sim_unmasking) return;
+
+    sim_unmasking = TRUE;
+    sim_deliver();
+    sim_unmasking = FALSE;
+}
+
+// an IRQ the VIC would give but the I bit holds off
+static bool sim_irq_held(void) {
+    return (host_cpsr & IRQ_MASK) &&
+           vic_pick(vic_raw() & vic_en & ~VIC_REG(0x00C)) < vic_top();
+}
+
+// one shot, re-armed at the end of sim_idle: however long
+// that took, the spin gets a whole tick of CPU time
+static void sim_idle_arm(void) {
+    struct itimerval it;
+
+    memset(&it, 0, sizeof(it));
+    it.it_value.tv_usec = SIM_IDLE_CPU_US;
+    setitimer(ITIMER_VIRTUAL, &it, 0);
+}
+
+/*
+ * sim_idle
+ * ------------------------------
+ * No register access for a whole host tick: the code
+ * spins on RAM, waiting for an interrupt. Time moves
+ * until one is taken, not while one is held off by a
+ * critical section in the spin (uart_txflush).
+ */
+static void sim_idle(int sig) {
+    static U32 mark;
+    U32 left, n;
+
+    if(!sim_busy && !sim_unmasking && sim_accesses == mark) {
+        left = (cclk_hz / 1000000) * SIM_IDLE_US;
+        for(;;) {
+            sim_deliver();
+            if(left == 0 || sim_accesses != mark || sim_irq_held()) break;
+
+            n     = (left > SIM_WARP_MAX) ? SIM_WARP_MAX : left;
+            left -= n;
+            sim_advance(n);
+        }
+    }
+    mark = sim_accesses;
+    sim_idle_arm();
+}
+
+static void sim_map(U32 base, U32 len) {
+    void *p = mmap((void *) (uintptr_t) base, len, PROT_NONE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if(p != (void *) (uintptr_t) base) sim_fatal("sim: cannot map the register pages\n");
+}
+
+/*
+ * sim_init
+ * ------------------------------
+ */
+void sim_init(void) {
+    struct sigaction sa;
+
+    sim_map(APB_BASE, APB_SIZE);
+    sim_map(VIC_BASE, PAGE_SIZE);
+    sim_map(FIO_BASE, PAGE_SIZE);
+
+    // reset values
+    cclk_hz = SIM_FOSC;
+    apb_div = 4;
+    REG(UART0_BASE + 0x28) = 0x10;
+    REG(UART1_BASE + 0x28) = 0x10;
+    uart[0].thre = uart[1].thre = TRUE;
+
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sigaddset(&sa.sa_mask, SIGVTALRM);
+    sa.sa_flags     = SA_SIGINFO | SA_NODEFER;
+    sa.sa_sigaction = sim_segv;
+    sigaction(SIGSEGV, &sa, 0);
+    sa.sa_sigaction = sim_trap;
+    sigaction(SIGTRAP, &sa, 0);
+
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags   = SA_RESTART;
+    sa.sa_handler = sim_idle;
+    sigaction(SIGVTALRM, &sa, 0);
+
+    host_unmask = sim_unmask;
+
+    sim_idle_arm();
+}
+
+/*
+ * sim_cycles / sim_us / sim_cclk
+ * ------------------------------
+ */
+U64 sim_cycles(void) {
+    return sim_cyc;
+}
+
+U64 sim_us(void) {
+    return sim_ps / 1000000;
+}
+
+U32 sim_cclk(void) {
+    return cclk_hz;
+}
+
+/*
+ * sim_uart_rx
+ * ------------------------------
+ * SIGVTALRM off: the idle tick moves the queue too.
+ */
+U32 sim_uart_rx(U8 port, const char *s) {
+    sim_uart_t *u = &uart[port & 0x1];
+    sigset_t    block, old;
+    U32         n = 0;
+
+    sigemptyset(&block);
+    sigaddset(&block, SIGVTALRM);
+    sigprocmask(SIG_BLOCK, &block, &old);
+
+    if(u->in_n == 0) u->in_left = uart_char_time(u);
+    while(s[n] && u->in_n < SIM_UART_INLEN) {
+        u->in[(u->in_h + u->in_n) % SIM_UART_INLEN] = s[n++];
+        ++u->in_n;
+    }
+
+    sigprocmask(SIG_SETMASK, &old, 0);
+    return n;
+}
+
+/*
+ * sim_uart_output
+ * ------------------------------
+ */
+void sim_uart_output(U8 port, int fd) {
+    uart[port & 0x1].fd = fd;
+}
+
+/*
+ * sim_uart_sent
+ * ------------------------------
+ */
+U32 sim_uart_sent(U8 port) {
+    return uart[port & 0x1].sent;
+}
+
+/*
+ * sim_eint
+ * ------------------------------
+ */
+void sim_eint(U8 n) {
+    eint_flags |= (1 << (n & 0x3));
+}
+
+/*
+ * sim_gpio_in / sim_gpio_pins
+ * ------------------------------
+ */
+void sim_gpio_in(U8 port, U32 pins) {
+    gpio_in[port & 0x1] = pins;
+}
+
+U32 sim_gpio_pins(U8 port) {
+    return gpio_pins(port & 0x1);
+}
+
+U32 sim_gpio_dir(U8 port) {
+    return gpio_dir[port & 0x1];
+}
@@ -0,0 +1,37 @@
+
+/*
+ * irq-nest.h
+ */
+
+#ifndef _IRQ_NEST_H
+#define _IRQ_NEST_H
+
+
+#include "types.h"
+#include "lpc214x.h"
+
+// timer0 match every 100us at 60MHz: the high priority IRQ
+#define FAST_PERIOD           6000
+
+// timer1 match every 1ms, its handler spins 500us
+#define SLOW_PERIOD           60000
+#define SLOW_BUSY             30000
+
+// slow ticks per run
+#define RUN_TICKS             1000
+
+// VIC priorities
+#define FAST_PRIORITY         0
+#define SLOW_PRIORITY         8
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * initialize the lpc2148 pll
+ * the uart0 serial port
+ * timer0 and timer1, unprescaled
+ */
+void initialize(void);
+
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * irq-nest.c
+ * -------------------------
+ * Worst case latency of a high priority timer IRQ
+ * while a low priority ISR is busy, with the low
+ * priority handler attached the usual way and then
+ * with irq_attach_nested.
+ *
+ * timer0 (priority FAST_PRIORITY) matches every
+ * FAST_PERIOD cycles, its handler reads how far T0TC
+ * has run past the match. timer1 (SLOW_PRIORITY)
+ * matches every SLOW_PERIOD cycles and its handler
+ * spins SLOW_BUSY cycles, like a handler that prints.
+ *
+ * Both timers count PCLK with no prescale and
+ * hwSysInit sets APBDIV 1, so one tick is one
+ * CPU cycle.
+ */
+
+
+#include "./include/irq-nest.h"
+
+
+#include "lpc214x.h"
+#include "types.h"
+#include "olimex.h"
+#include "helpers.h"
+#include "hwsys.h"
+#include "conio.h"
+#include "interrupts.h"
+#include "lpc-timer.h"
+
+static volatile U32 fast_max;
+static volatile U32 fast_count;
+static volatile U32 slow_count;
+
+/*
+ * TIMER0_Handler
+ * ------------------------------
+ * Latency is how far T0TC is past the match.
+ */
+void TIMER0_Handler(void) __attribute__ ((interrupt("IRQ")));
+void TIMER0_Handler(void) {
+    U32 lat;
+
+    lat = T0TC - T0MR0;
+    if(lat > fast_max) fast_max = lat;
+    ++fast_count;
+
+    // next match; if we missed it, start again from now
+    if(lat < FAST_PERIOD) T0MR0 += FAST_PERIOD;
+    else                  T0MR0  = T0TC + FAST_PERIOD;
+
+    T0IR = 0x1;
+    EXIT_INTERRUPT;
+}
+
+/*
+ * slow_busy
+ * ------------------------------
+ * timer1 resets on the match, spin until it
+ * has counted SLOW_BUSY cycles.
+ */
+static void slow_busy(void) {
+    T1IR = 0x1;
+    ++slow_count;
+    while(T1TC < SLOW_BUSY);
+}
+
+/*
+ * TIMER1_Handler
+ * ------------------------------
+ * Not nested: IRQ stays disabled while it spins.
+ */
+void TIMER1_Handler(void) __attribute__ ((interrupt("IRQ")));
+void TIMER1_Handler(void) {
+    slow_busy();
+    EXIT_INTERRUPT;
+}
+
+/*
+ * timer1_nested
+ * ------------------------------
+ * Same work, run by irq_attach_nested.
+ */
+void timer1_nested(void) {
+    slow_busy();
+}
+
+/*
+ * run
+ * ------------------------------
+ * RUN_TICKS of timer1, then report.
+ */
+static void run(const char *name) {
+
+    fast_max   = 0;
+    fast_count = 0;
+    slow_count = 0;
+
+    T0MR0 = T0TC + FAST_PERIOD;
+    RESET_T0IR;
+    RESET_TIMER1;
+    RESET_T1IR;
+    irq_attach(TIMER0_CHANNEL, (U32) TIMER0_Handler, FAST_PRIORITY);
+
+    while(slow_count < RUN_TICKS);
+
+    disableTIMER0_INT();
+    irq_detach(TIMER1_CHANNEL);
+
+    printf("%-8s worst %6u cycles (%u us), %u fast / %u slow ticks\n",
+           name, fast_max, fast_max / (hwSysPclkVal() / 1000000),
+           fast_count, slow_count);
+}
+
+int main() {
+
+    initialize();
+
+    LED1_ON;
+    LED2_OFF;
+    printf("Hello: irq-nest. timer0 latency while timer1 spins %u cycles\n", SLOW_BUSY);
+
+    irq_attach(TIMER1_CHANNEL, (U32) TIMER1_Handler, SLOW_PRIORITY);
+    run("plain");
+
+    irq_attach_nested(TIMER1_CHANNEL, (U32) timer1_nested, SLOW_PRIORITY);
+    run("nested");
+
+    printf("\ndone.\n");
+    LED2_ON;
+
+    while (1);
+
+    return(0);
+}
+
+
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * initialize the lpc2148 pll
+ * the uart0 serial port
+ * timer0 free running with a match interrupt
+ * timer1 resetting on its match
+ * IRQ on
+ */
+void initialize(void)  {
+    // PLL and MAM, APBDIV 1: PCLK == CCLK
+    hwSysInit(SIXTY_MHZ);
+
+    // enable the leds
+    enable_leds();
+
+    console0Init(ONE_FIFTEEN_TWO_B);
+
+    // timer0: interrupt on MR0, keep counting
+    SET_T0CTCR(0x0);
+    SET_PRESCALE0(0);
+    SET_MATCH_CONTROL_0(0x1);
+    RESET_TIMER0;
+    ENABLE_TIMER0;
+
+    // timer1: interrupt and reset on MR0
+    SET_T1CTCR(0x0);
+    SET_PRESCALE1(0);
+    T1MR0 = SLOW_PERIOD;
+    SET_MATCH_CONTROL_1(0x3);
+    RESET_TIMER1;
+    ENABLE_TIMER1;
+
+    // crt.s starts main with IRQ disabled
+    enableIRQ();
+}
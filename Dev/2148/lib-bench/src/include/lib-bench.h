@@ -0,0 +1,29 @@
+
+/*
+ * lib-bench.h
+ */
+
+#ifndef _LIB_BENCH_H
+#define _LIB_BENCH_H
+
+
+#include "types.h"
+#include "lpc214x.h"
+
+// U0LSR: transmitter empty, THR and shift register
+#define LSR_TEMT              0x40
+
+// the VIC slot update_VIC_table rewrites, left disabled
+#define SPARE_VIC_SLOT        15
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * initialize the lpc2148 pll
+ * the uart0 serial port
+ * the rtc, the time base and the bench timer
+ */
+void initialize(void);
+
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * lib-bench.c
+ * -------------------------
+ * Cycles per call of libs-lpc functions at every
+ * CCLK hwSysInit supports, each with the MAM off,
+ * partly and fully enabled.
+ *
+ * 'r' runs the suite again.
+ */
+
+
+#include "./include/lib-bench.h"
+
+
+#include "lpc214x.h"
+#include "types.h"
+#include "olimex.h"
+#include "helpers.h"
+#include "hwsys.h"
+#include "mam.h"
+#include "pll.h"
+#include "conio.h"
+#include "interrupts.h"
+#include "lpc-uart.h"
+#include "lpc-rtc.h"
+#include "lpc-timer.h"
+#include "bench.h"
+
+static const freq_t freqs[] = {
+    TWELVE_MHZ, TWENTYFOUR_MHZ, THIRTYSIX_MHZ, FOURTYEIGHT_MHZ, SIXTY_MHZ
+};
+
+static volatile U32 sink;
+
+/*
+ * Benchmarks
+ * ------------------------------
+ */
+static void b_null(U32 arg) {
+}
+
+static void b_snprintf_d(U32 arg) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", (int) arg);
+}
+
+static void b_snprintf_x(U32 arg) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%08x", arg);
+}
+
+static void b_snprintf_f(U32 arg) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", (double) arg / 1000.0);
+}
+
+static void b_itoa(U32 arg) {
+    sink = (U32) itoa((int) arg, 10);
+}
+
+static void b_utoa_r(U32 arg) {
+    char buf[ITOA_BUFLEN];
+    utoa_r(arg, buf, 16);
+}
+
+static void b_rtc_readSecs(U32 arg) {
+    sink = rtc_readSecs();
+}
+
+static void b_pll0_feed(U32 arg) {
+    pll0_feed();
+}
+
+static void b_update_VIC_table(U32 arg) {
+    update_VIC_table(SPARE_VIC_SLOT, arg, 0x0);
+}
+
+static void b_irq_save(U32 arg) {
+    irq_restore(irq_save());
+}
+
+static void b_time_now(U32 arg) {
+    sink = (U32) time_now_cycles();
+}
+
+static const bench_t suite[] = {
+    { "(residual overhead)",          b_null,              0,          0   },
+    { "snprintf %d -123456",          b_snprintf_d,        -123456,    0   },
+    { "snprintf %08x",                b_snprintf_x,        0xBEEF,     0   },
+    { "snprintf %.3f 1234.567",       b_snprintf_f,        1234567,    100 },
+    { "itoa 123456",                  b_itoa,              123456,     0   },
+    { "utoa_r 0xFFFFFFFF base 16",    b_utoa_r,            0xFFFFFFFF, 0   },
+    { "rtc_readSecs",                 b_rtc_readSecs,      0,          0   },
+    { "pll0_feed",                    b_pll0_feed,         0,          0   },
+    { "update_VIC_table",             b_update_VIC_table,  0,          0   },
+    { "irq_save + irq_restore",       b_irq_save,          0,          0   },
+    { "time_now_cycles",              b_time_now,          0,          0   }
+};
+
+/*
+ * set_clock
+ * ------------------------------
+ * Let the UART finish, change CCLK, bring the
+ * console and the timers back at the new rate.
+ */
+static void set_clock(freq_t f) {
+    uart_txflush(0);
+    while(!(U0LSR & LSR_TEMT));
+
+    hwSysInit(f);
+
+    console0Init(ONE_FIFTEEN_TWO_B);
+    time_init(0);
+    bench_init();
+}
+
+/*
+ * run_suite
+ * ------------------------------
+ */
+static void run_suite(void) {
+    U32 i, n = sizeof(suite) / sizeof(suite[0]);
+    U8  mamcr, mamtim;
+
+    for(i = 0; i < sizeof(freqs) / sizeof(freqs[0]); ++i) {
+        set_clock(freqs[i]);
+
+        // hwSysInit's wait states, MAM off, partial, full
+        mamtim = read_MAMTIM() & 0x7;
+        for(mamcr = 0; mamcr <= 2; ++mamcr) {
+            write_MAM(mamcr, mamtim);
+            bench_report(suite, n);
+        }
+    }
+}
+
+int main() {
+
+    initialize();
+
+    LED1_ON;
+    LED2_OFF;
+    printf("Hello: lib-bench. %d calls each, best of %d\n", BENCH_REPS, BENCH_TRIES);
+
+    run_suite();
+    printf("\ndone. 'r' runs it again\n");
+    LED2_ON;
+
+    while (1) {
+        if(serial_trygetchar() == 'r') {
+            LED2_OFF;
+            run_suite();
+            printf("\ndone.\n");
+            LED2_ON;
+        }
+    }
+
+    return(0);
+}
+
+
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * initialize the lpc2148 pll
+ * the uart0 serial port
+ * the rtc, the time base and the bench timer
+ */
+void initialize(void)  {
+    // PLL and MAM, APBDIV 1: PCLK == CCLK
+    hwSysInit(SIXTY_MHZ);
+
+    // enable the leds
+    enable_leds();
+
+    console0Init(ONE_FIFTEEN_TWO_B);
+
+    rtc_init(SOURCE_RTCX);
+
+    time_init(0);
+    bench_init();
+
+    // crt.s starts main with IRQ disabled
+    enableIRQ();
+}
@@ -0,0 +1,139 @@
+
+/*
+ * bench.c
+ * -------------------------------------------
+ * Micro-benchmark harness, see bench.h
+ */
+
+#include "./include/bench.h"
+
+#include "lpc214x.h"
+#include "types.h"
+#include "helpers.h"
+#include "hwsys.h"
+#include "mam.h"
+#include "interrupts.h"
+#include "lpc-timer.h"
+
+/*
+ * bench_null
+ * ------------------------------
+ * The overhead: loop, call and return.
+ */
+static void bench_null(U32 arg) {
+}
+
+/*
+ * bench_init
+ * ------------------------------
+ */
+void bench_init(void) {
+    DISABLE_TIMER0;
+    SET_T0CTCR(0x0);
+    SET_PRESCALE0(0);
+    RESET_MATCH_CONTROL_0;
+    RESET_TIMER0;
+    ENABLE_TIMER0;
+}
+
+/*
+ * bench_ticks
+ * ------------------------------
+ */
+U32 bench_ticks(bench_fn fn, U32 arg, U32 reps) {
+    U32 cpsr, start, ticks, best = 0xFFFFFFFF;
+    U32 t, n;
+
+    for(t = 0; t < BENCH_TRIES; ++t) {
+        cpsr  = irq_save();
+        start = T0TC;
+        for(n = 0; n < reps; ++n) fn(arg);
+        ticks = T0TC - start;
+        irq_restore(cpsr);
+
+        if(ticks < best) best = ticks;
+    }
+    return best;
+}
+
+/*
+ * bench_cycles10
+ * ------------------------------
+ */
+U32 bench_cycles10(const bench_t *b) {
+    U32 reps, ticks, overhead;
+
+    reps     = b->reps ? b->reps : BENCH_REPS;
+    overhead = bench_ticks(bench_null, b->arg, reps);
+    ticks    = bench_ticks(b->fn, b->arg, reps);
+
+    ticks = (ticks > overhead) ? ticks - overhead : 0;
+
+    // PCLK ticks to CCLK cycles
+    return (U32) (((U64) ticks * 10 * (hwSysCclkVal() / 1000)) /
+                  ((U64) reps * (hwSysPclkVal() / 1000)));
+}
+
+/*
+ * bench_report
+ * ------------------------------
+ */
+void bench_report(const bench_t *suite, U32 n) {
+    U32 i, c10;
+
+    printf("\nCCLK %d MHz  MAMCR %u MAMTIM %u  cycles/call\n",
+           hwSysCclkVal() / 1000000, read_MAMCR() & 0x3, read_MAMTIM() & 0x7);
+
+    for(i = 0; i < n; ++i) {
+        c10 = bench_cycles10(&suite[i]);
+        printf("  %-28s %7u.%u\n", suite[i].name, c10 / 10, c10 % 10);
+    }
+}
+
+/*
+ * bench_mam_cycles10
+ * ------------------------------
+ * The suite's cycles10 under one MAM setting, 0 when
+ * sig does not give ref.
+ */
+static U32 bench_mam_cycles10(const bench_t *suite, U32 n, bench_sig_fn sig,
+                              U32 ref, U8 mamcr, U8 mamtim) {
+    U32 i, sum = 0;
+
+    write_MAM(mamcr, mamtim);
+
+    for(i = 0; i < BENCH_TRIES; ++i) {
+        if(sig() != ref) return 0;
+    }
+    for(i = 0; i < n; ++i) sum += bench_cycles10(&suite[i]);
+
+    return sum ? sum : 1;
+}
+
+/*
+ * bench_mam_tune
+ * ------------------------------
+ * Off at MAMTIM 7 is the reference: every flash fetch
+ * takes the full access time.
+ */
+U8 bench_mam_tune(const bench_t *suite, U32 n, bench_sig_fn sig) {
+    U32 ref, c10, best = 0xFFFFFFFF;
+    U8  mamcr, mamtim, best_cr = 0x0, best_tim = 0x7;
+
+    write_MAM(0x0, 0x7);
+    ref = sig();
+
+    for(mamcr = 0; mamcr <= 2; ++mamcr) {
+        for(mamtim = hwSysMamtim(hwSysCclkVal()); mamtim <= 7; ++mamtim) {
+            c10 = bench_mam_cycles10(suite, n, sig, ref, mamcr, mamtim);
+            if(c10 && c10 < best) {
+                best     = c10;
+                best_cr  = mamcr;
+                best_tim = mamtim;
+            }
+        }
+    }
+    write_MAM(best_cr, best_tim);
+
+    return (U8) (best_cr << 4 | best_tim);
+}
@@ -3,112 +3,80 @@
  * conio.c
  * -------------------------------------------
  * Simple serial port console routines 
- * using the LPC2148 UART0 and UART1
+ * using the LPC2148 UART0 and UART1.
+ * The work is done by the port generic
+ * driver in lpc-uart.c.
  */
 
 
 #include "./include/conio.h"
-#include "hwsys.h"
 
 #include "types.h"
 #include "lpc214x.h"
-#include "helpers.h"
+#include "lpc-uart.h"
 
 /*
  * console0Init
  * ---------------------------------------
  * Initialize the serial port for UART0
- *
- * Fix to 8N1 for simplicity.
- * Fix to one char for interrupt for simplicity.
  */
 void console0Init(baud_t baudRate) {
-
-    U16 divisor;
-
-    if(hwSysPclkVal() == TWELVE_MHZ) {
-        divisor = (U16) floor(hwSysPclkVal()/(16 * baudRate));
-        if(baudRate == ONE_FIFTEEN_TWO_B) {
-            // Set the Fractional divide register to get baud to 115384.6
-            U0FDR = (12 << 4) | 1 ;
-        }
-    } else {
-        divisor = (U16) floor(hwSysPclkVal()/(16 * baudRate));
-    }
-
-    PINSEL0 = (PINSEL0 & TXD_RXD_0_PINSEL0_MASK) | TXD_RXD_0_ENABLE ;
-
-    PCONP |= 0x08;
-    // uart control register. Set DLAB (lcr bit 7) 
-    //   to access divisor latches, for fractional baud rate.
-    U0LCR = U0LCR_8N1 | ~U0LCR_DLAB_MASK; 
-
-    // U0DLL is lower 8 bits of divisor.
-    // baud rate CLOCK (must =) 16 x Baud rate goal.
-    if(divisor == 0x0) 
-        U0DLL = 0x1; // Don't divide by zero. Ever.
-    else
-        U0DLL = (divisor & 0xFF);
-
-    // U16 is unsigned type, so this is a LOGICAL shift! 
-    // No sign bit preservation....i.e. this is a + number. 
-    U0DLM  = divisor >> 8; 
-
-    // uart control. Clear DLAB, no more access needed.
-    U0LCR = U0LCR & U0LCR_DLAB_MASK;
-
-    // enable FIFO
-    U0FCR = U0FCR_EN_ONE_CHAR;
+    uart_init(0, baudRate);
 }
 
 /*
  * console1Init
  * ---------------------------------------
  * Initialize the serial port for UART1
- *
- * Fix to 8N1 for simplicity.
- * Fix to one char for interrupt for simplicity.
  */
 void console1Init(baud_t baudRate) {
+    uart_init(1, baudRate);
+}    
 
-    U16 divisor;
-
-    if(hwSysPclkVal() == TWELVE_MHZ) {
-        divisor = (U16) floor(hwSysPclkVal()/(16 * baudRate));
-        if(baudRate == ONE_FIFTEEN_TWO_B) {
-            // Set the Fractional divide register to get baud to 115384.6
-            U1FDR = (12 << 4) | 1 ;
-        }
-    } else {
-        divisor = (U16) floor(hwSysPclkVal()/(16 * baudRate));
-    }
-
-    PINSEL0 = (PINSEL0 & TXD_RXD_1_PINSEL0_MASK) | TXD_RXD_1_ENABLE ;
-
-    PCONP |= 0x10;
-    // uart control register. Set DLAB (lcr bit 7) 
-    //   to access divisor latches, for fractional baud rate.
-    U1LCR = U1LCR_8N1 | ~U1LCR_DLAB_MASK; 
-
-    // U1DLL is lower 8 bits of divisor.
-    // baud rate CLOCK (must =) 16 x Baud rate goal.
-    if(divisor == 0x0) 
-        U1DLL = 0x1; // Don't divide by zero. Ever.
-    else
-        U1DLL = (divisor & 0xFF);
-
-    // U16 is unsigned type, so this is a LOGICAL shift! 
-    // No sign bit preservation....i.e. this is a + number. 
-    U1DLM  = divisor >> 8; 
+/*
+ * console0TxBuffer
+ * ---------------------------------------
+ * Switch UART0 output to interrupt driven mode.
+ */
+void console0TxBuffer(U16 isr_vec, txpolicy_t policy) {
+    uart_txbuffer(0, isr_vec, policy);
+}
 
-    // uart control. Clear DLAB, no more access needed.
-    U1LCR = U1LCR & U1LCR_DLAB_MASK;
+/*
+ * console0TxFlush
+ * ---------------------------------------
+ * Wait until the ring buffer is empty.
+ */
+void console0TxFlush(void) {
+    uart_txflush(0);
+}
 
-    // enable FIFO
-    U1FCR = U1FCR_EN_ONE_CHAR;
-}    
+/*
+ * console0TxDropped
+ * ---------------------------------------
+ * chars lost to the overflow policy.
+ */
+U32 console0TxDropped(void) {
+    return(uart_txdropped(0));
+}
 
+/*
+ * console0RxBuffer
+ * ---------------------------------------
+ * Switch UART0 input to interrupt driven mode.
+ */
+void console0RxBuffer(U16 isr_vec) {
+    uart_rxbuffer(0, isr_vec);
+}
 
+/*
+ * console0RxOverruns
+ * ---------------------------------------
+ * received chars that were lost.
+ */
+U32 console0RxOverruns(void) {
+    return(uart_rxoverruns(0));
+}
 
 /*
  * serial_getline
@@ -144,30 +112,37 @@ char* serial_getline (void)  {
  * Return a char (U8).
  */
 char serial_getchar (void)  {
-  
-    while (U0RBR_EMPTY);
-
-    return (U0RBR);
+    return (uart_getchar(0));
 }
 
+/*
+ * serial_trygetchar
+ * --------------------------------------
+ * Next received char or -1.
+ */
+int serial_trygetchar (void)  {
+    return (uart_trygetchar(0));
+}
 
+/*
+ * serial_getline_nb
+ * --------------------------------------
+ * Non blocking (or time limited) line assembly
+ * into a caller buffer.
+ */
+int serial_getline_nb(line_t *line, U32 timeout_ms) {
+    return (uart_getline_nb(0, line, timeout_ms));
+}
 
 /*
  * putchar
  * -------------------------------------
  * put a char to the serial port
- * 
+ * In buffered mode (console0TxBuffer) the char is
+ * queued and putchar returns right away.
  */
 int putchar(int ch) {
-
-    if (ch == '\n') {
-        while (!(U0LSR & 0x20));
-        U0THR = '\r';
-    } 
-    while (!(U0LSR & 0x20));
-    U0THR = ch;
-
-    return ch;
+    return (uart_putchar(0, ch));
 }
 
 
@@ -178,20 +153,10 @@ int putchar(int ch) {
  * 
  */
 int putchar_u1(int ch) {
-
-    if (ch == '\n') {
-        while (!(U1LSR & 0x20));
-        U1THR = '\r';
-    } 
-    while (!(U1LSR & 0x20));
-    U1THR = ch;
-
-    return ch;
+    return (uart_putchar(1, ch));
 }
 
 
-
-
 /*
  * puts
  * -------------------------------------
@@ -200,12 +165,7 @@ int putchar_u1(int ch) {
  * Assumes null termination of string.
  */
 int puts(const char *s) {
-
-    while(*s) {
-        putchar(*s++); // put the char
-    }
-    putchar('\n');
-    return(1);
+    return (uart_puts(0, s));
 }
 
 
@@ -217,12 +177,6 @@ int puts(const char *s) {
  * Assumes null termination of string.
  */
 int puts_u1(const char *s) {
-
-    while(*s) {
-        putchar_u1(*s++); // put the char
-    }
-    putchar_u1('\n');
-    return(1);
+    return (uart_puts(1, s));
 }
 
-
@@ -0,0 +1,103 @@
+
+/*
+ * defer.c
+ * -------------------------------------------
+ * Deferred work queue, see defer.h
+ */
+
+#include "./include/defer.h"
+
+#include "lpc214x.h"
+#include "types.h"
+#include "interrupts.h"
+
+#define DEFER_MASK  (DEFER_LEN - 1)
+
+typedef struct {
+    defer_fn fn;
+    U32      arg;
+} defer_entry_t;
+
+static defer_entry_t defer_q[DEFER_LEN];
+
+// head is written by defer_post only, tail by defer_run only
+static volatile U32  defer_head;
+static volatile U32  defer_tail;
+static volatile U32  defer_lost;
+
+/*
+ * defer_run
+ * ------------------------------
+ * The nested handler. The flag is cleared first so a
+ * post made while we run raises the interrupt again;
+ * the VIC holds it off until we return.
+ */
+static void defer_run(void) {
+    defer_entry_t e;
+    U32 t;
+
+    VICSoftIntClr = (0x1 << DEFER_CHANNEL);
+
+    t = defer_tail;
+    while(t != defer_head) {
+        e = defer_q[t];
+        t = (t + 1) & DEFER_MASK;
+
+        // free the entry before the call, it may post
+        defer_tail = t;
+        e.fn(e.arg);
+    }
+}
+
+/*
+ * defer_init
+ * ------------------------------
+ */
+int defer_init(U8 priority) {
+    U32 cpsr;
+
+    cpsr = irq_save();
+    VICSoftIntClr = (0x1 << DEFER_CHANNEL);
+    defer_head    = 0;
+    defer_tail    = 0;
+    defer_lost    = 0;
+    irq_restore(cpsr);
+
+    return irq_attach_nested(DEFER_CHANNEL, (U32) defer_run, priority);
+}
+
+/*
+ * defer_post
+ * ------------------------------
+ * Handlers nest, so the slot is claimed with IRQ off.
+ */
+int defer_post(defer_fn fn, U32 arg) {
+    U32 cpsr, h, next;
+
+    cpsr = irq_save();
+
+    h    = defer_head;
+    next = (h + 1) & DEFER_MASK;
+    if(next == defer_tail) {
+        ++defer_lost;
+        irq_restore(cpsr);
+        return 0;
+    }
+
+    defer_q[h].fn  = fn;
+    defer_q[h].arg = arg;
+    defer_head     = next;
+
+    VICSoftInt = (0x1 << DEFER_CHANNEL);
+
+    irq_restore(cpsr);
+    return 1;
+}
+
+/*
+ * defer_dropped
+ * ------------------------------
+ */
+U32 defer_dropped(void) {
+    return defer_lost;
+}
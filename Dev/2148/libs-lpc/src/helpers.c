@@ -7,6 +7,121 @@
 
 // #include <stdio.h>
 
+#include "./include/helpers.h"
+
+#include "types.h"
+
+/*
+ * "00" "01" ... "99": two decimal digits per lookup.
+ */
+static const char digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static const U32 dec_limits[9] = {
+    10, 100, 1000, 10000, 100000,
+    1000000, 10000000, 100000000, 1000000000
+};
+
+/*
+ * umulhi
+ * ------------------------------
+ * high word of the 64 bit product a*b. One UMULL
+ * on the ARM7TDMI (3-6 cycles) where __udivsi3 takes
+ * 40 and up.
+ */
+static inline U32 umulhi(U32 a, U32 b) {
+#ifdef __arm__
+    U32 lo, hi;
+
+    asm (" umull %0, %1, %2, %3" : "=&r" (lo), "=&r" (hi) : "r" (a), "r" (b));
+    return hi;
+#else
+    return (U32) (((unsigned long long) a * b) >> 32);
+#endif
+}
+
+// exact for every 32 bit n
+#define UDIV10(n)       (umulhi((n), 0xCCCCCCCD) >> 3)
+#define UDIV100(n)      (umulhi((n), 0x51EB851F) >> 5)
+
+/*
+ * utoa_r
+ * ------------------------------
+ * Base 10 works two digits at a time with a
+ * reciprocal multiply for /100; bases 2, 8 and 16 are
+ * shift and mask. Only other bases divide.
+ */
+int utoa_r(U32 val, char *buf, int base) {
+    char *p;
+    U32   q, r;
+    int   len, shift;
+
+    if(base == 10) {
+        for(len = 1; len < 10 && val >= dec_limits[len - 1]; ++len);
+        p  = buf + len;
+        *p = '\0';
+        while(val >= 100) {
+            q    = UDIV100(val);
+            r    = (val - q * 100) << 1;
+            *--p = digit_pairs[r + 1];
+            *--p = digit_pairs[r];
+            val  = q;
+        }
+        if(val >= 10) {
+            r    = val << 1;
+            *--p = digit_pairs[r + 1];
+            *--p = digit_pairs[r];
+        } else {
+            *--p = '0' + val;
+        }
+        return(len);
+    }
+
+    if(base == 16 || base == 8 || base == 2) {
+        shift = (base == 16) ? 4 : (base == 8) ? 3 : 1;
+        for(len = 1, q = val >> shift; q; q >>= shift) ++len;
+        p  = buf + len;
+        *p = '\0';
+        do {
+            *--p = hex_digits[val & (base - 1)];
+            val >>= shift;
+        } while(val);
+        return(len);
+    }
+
+    // any other base: divide.
+    if(base < 2 || base > 16) base = 10;
+    for(len = 1, q = val / base; q; q /= base) ++len;
+    p  = buf + len;
+    *p = '\0';
+    do {
+        *--p = hex_digits[val % base];
+        val /= base;
+    } while(val);
+    return(len);
+}
+
+/*
+ * itoa_r
+ * ------------------------------
+ * signed in base 10, two's complement bits otherwise.
+ */
+int itoa_r(int val, char *buf, int base) {
+
+    if(base == 10 && val < 0) {
+        buf[0] = '-';
+        // -(U32) so INT_MIN does not overflow
+        return(1 + utoa_r(-(U32) val, buf + 1, 10));
+    }
+    return(utoa_r((U32) val, buf, base));
+}
+
 /*
  * itoa
  * ------------------------------
@@ -16,18 +131,11 @@
  */
 char* itoa(int val, int base){
 
-    static char ibuf[32] = {0};
-
-    int i = 30;
+    static char ibuf[ITOA_BUFLEN];
 
-    if(val == 0) { return "0"; }
-    else {
-	for(; val && i ; --i, val /= base)
+    itoa_r(val, ibuf, base);
 
-	    ibuf[i] = "0123456789abcdef"[val % base];
-
-	return &ibuf[i+1];
-    }
+    return ibuf;
 }
 
 
@@ -36,17 +144,48 @@ char* itoa(int val, int base){
  * float to ascii code
  * Copy return to a local var for long term usage
  */
-/* char* ftoa(float val)
+char* ftoa(float val)
 {
 	static char fbuf[20];
 
-	snprintf(fbuf, 19, "%f", val);
+	snprintf(fbuf, sizeof(fbuf), "%f", val);
 
-//	printf("Here is the result: %s\n", halfpie);
 	return &fbuf[0];
 }
-*/
 
 
 
 
+
+
+/*
+ * memcpy_fast
+ * ------------------------------
+ * Unaligned or short: a byte at a time. The tail of
+ * an aligned copy too.
+ */
+RAMFUNC void *memcpy_fast(void *dst, const void *src, size_t n) {
+    U8        *d = (U8 *) dst;
+    const U8  *s = (const U8 *) src;
+    U32       *dw;
+    const U32 *sw;
+
+    if((((U32) d | (U32) s) & 0x3) == 0) {
+        dw = (U32 *) d;
+        sw = (const U32 *) s;
+        for(; n >= 16; n -= 16) {
+            dw[0] = sw[0];
+            dw[1] = sw[1];
+            dw[2] = sw[2];
+            dw[3] = sw[3];
+            dw += 4;
+            sw += 4;
+        }
+        for(; n >= 4; n -= 4) *dw++ = *sw++;
+        d = (U8 *) dw;
+        s = (const U8 *) sw;
+    }
+    while(n--) *d++ = *s++;
+
+    return dst;
+}
@@ -13,6 +13,10 @@
 /* global static */
 static int cclk_frequency_g;
 static int pclk_frequency_g;
+static U32 fosc_frequency_g = HWSYS_FOSC;
+
+static hwsys_freq_fn freq_fn_g[HWSYS_FREQ_CALLBACKS];
+static U32           freq_fn_n;
 
 
 /*
@@ -21,42 +25,87 @@ static int pclk_frequency_g;
  *  20 MHz and 40 MHz, Flash access time is suggested to be 2 CCLKs, while in systems
  *  with system clock faster than 40 MHz, 3 CCLKs are proposed.
  */
+U8 hwSysMamtim(U32 cclk) {
+  if(cclk < 20000000)  return(0x1);
+  if(cclk <= 40000000) return(0x2);
+  return(0x3);
+}
+
+/*
+ * hwsys_apply
+ * ------------------------------
+ * Flash wait states go up before the clock does,
+ * down after. mamcr is the MAM mode to end in.
+ */
+static void hwsys_apply(pll_config_t *cfg, U8 mamcr) {
+  U8 mamtim = hwSysMamtim(cfg->cclk);
+
+  if(mamtim > (read_MAMTIM() & 0x7)) write_MAM(read_MAMCR() & 0x3, mamtim);
+
+  pll0_run(cfg->psel, cfg->msel, cfg->apbdiv);
+  cclk_frequency_g = cfg->cclk;
+  pclk_frequency_g = cfg->pclk;
+
+  write_MAM(mamcr, mamtim);
+}
+
+bool hwSysInitClock(U32 fosc, U32 cclk, U32 pclk) {
+  pll_config_t cfg;
+
+  if(!pll0_solve(fosc, cclk, pclk, &cfg)) return(FALSE);
+
+  fosc_frequency_g = fosc;
+  hwsys_apply(&cfg, 0x2);
+
+  return(TRUE);
+}
+
+bool hwSysFreqNotify(hwsys_freq_fn fn) {
+  U32 i;
+
+  for(i = 0; i < freq_fn_n; ++i) {
+    if(freq_fn_g[i] == fn) return(TRUE);
+  }
+  if(freq_fn_n == HWSYS_FREQ_CALLBACKS) return(FALSE);
+
+  freq_fn_g[freq_fn_n++] = fn;
+  return(TRUE);
+}
+
+bool hwSysSetFreq(U32 cclk, U32 pclk) {
+  pll_config_t cfg;
+  U32          i;
+
+  if(!pll0_solve(fosc_frequency_g, cclk, pclk, &cfg)) return(FALSE);
+  if(cfg.cclk == (U32) cclk_frequency_g && cfg.pclk == (U32) pclk_frequency_g) return(TRUE);
+
+  for(i = 0; i < freq_fn_n; ++i) freq_fn_g[i](HWSYS_FREQ_PRE, cfg.cclk, cfg.pclk);
+
+  // keep the MAM mode, bench_mam_tune's or the caller's
+  hwsys_apply(&cfg, read_MAMCR() & 0x3);
+
+  for(i = 0; i < freq_fn_n; ++i) freq_fn_g[i](HWSYS_FREQ_POST, cfg.cclk, cfg.pclk);
+
+  return(TRUE);
+}
+
+/*
+ *  The five freq_t points, PCLK = CCLK, Fosc 12Mhz:
+ *  CCLK   M  P  Fcco
+ *  60Mhz  5  2  240Mhz
+ *  48Mhz  4  2  192Mhz
+ *  36Mhz  3  4  288Mhz
+ *  24Mhz  2  4  192Mhz
+ *  12Mhz  1  8  192Mhz
+ */
 void hwSysInit(freq_t cclkFreq) { 
   switch(cclkFreq) {
     case SIXTY_MHZ:
-      //  CCLK = 60Mhz, Fcco 240Mhz
-      //  APBDIV = 01 => 60Mhz PCLK
-      pll0_run(0x1,0x4, 0x01);
-      cclk_frequency_g = pclk_frequency_g = 60000000;
-      write_MAM(0x2,0x3);
-      break;
     case FOURTYEIGHT_MHZ:
-      //  CCLK = 48Mhz, Fcco 192Mhz
-      //  APBDIV = 01 => 48Mhz PCLK
-      pll0_run(0x1,0x3, 0x01);
-      cclk_frequency_g = pclk_frequency_g = 48000000;
-      write_MAM(0x2,0x3);
-      break;
     case THIRTYSIX_MHZ:
-      //  CCLK = 36Mhz, Fcco 280Mhz
-      //  APBDIV = 01 => 36Mhz PCLK
-      pll0_run(0x2,0x2, 0x01);
-      cclk_frequency_g = pclk_frequency_g = 36000000;
-      write_MAM(0x2,0x2);
-      break;
     case TWENTYFOUR_MHZ:
-      //  CCLK = 24Mhz, Fcco 192Mhz
-      //  APBDIV = 01 => 24Mhz PCLK
-      pll0_run(0x2,0x1, 0x01);
-      cclk_frequency_g = pclk_frequency_g = 24000000;
-      write_MAM(0x2,0x2);
-      break;
     case TWELVE_MHZ:
-      //  CCLK = 12Mhz, Fcco 192Mhz
-      //  APBDIV = 01 => 12Mhz PCLK
-      pll0_run(0x3,0x0, 0x01);
-      cclk_frequency_g = pclk_frequency_g = 12000000;
-      write_MAM(0x2,0x1);
+      hwSysInitClock(HWSYS_FOSC, cclkFreq, cclkFreq);
       break;
     default:
       // no debug print statement yet available...no console
@@ -83,9 +132,7 @@ void IRQ_Routine (void) {
 	while (1) ;	
 }
 
-void FIQ_Routine (void)  {
-	while (1) ;	
-}
+/* FIQ_Routine: interrupts.c, see fiq_attach */
 
 void SWI_Routine (void)  {
 	while (1) ;	
@@ -0,0 +1,99 @@
+
+/*
+ * bench.h
+ * -------------------------------------------
+ * Cycle counts of library calls on the target.
+ *
+ * A benchmark is a function called reps times between
+ * two reads of the timer0 TC, with IRQ disabled. The
+ * same loop around an empty function is measured first
+ * and subtracted, the best of BENCH_TRIES runs is kept
+ * for both, and the ticks are scaled from PCLK to CCLK.
+ *
+ * bench_init takes timer0: not with the timer wheel.
+ * IRQ is off while a benchmark runs, so it must not
+ * wait on an interrupt (use snprintf, not printf).
+ *
+ * Example:
+ *   static void b_itoa(U32 arg) { char b[12]; itoa_r(arg, b, 10); }
+ *
+ *   static const bench_t suite[] = {
+ *       { "itoa_r 1234", b_itoa, 1234, 0 },
+ *   };
+ *   bench_init();
+ *   bench_report(suite, 1);
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include "types.h"
+
+// default calls per measurement, and measurements kept the best of
+#define BENCH_REPS           1000
+#define BENCH_TRIES          3
+
+typedef void (*bench_fn)(U32 arg);
+
+// a result that must not depend on the MAM setting
+typedef U32  (*bench_sig_fn)(void);
+
+typedef struct {
+    const char  *name;
+    bench_fn     fn;
+    U32          arg;            // passed to every call
+    U32          reps;           // 0 for BENCH_REPS
+} bench_t;
+
+/*
+ * bench_init
+ * ------------------------------
+ * timer0 free running at PCLK, no match. Again after
+ * every hwSysInit.
+ */
+void bench_init(void);
+
+/*
+ * bench_ticks
+ * ------------------------------
+ * Timer0 ticks of reps calls fn(arg) in the bench loop,
+ * the best of BENCH_TRIES.
+ */
+U32 bench_ticks(bench_fn fn, U32 arg, U32 reps);
+
+/*
+ * bench_cycles10
+ * ------------------------------
+ * CCLK cycles of one call in tenths, without the loop
+ * and call overhead.
+ */
+U32 bench_cycles10(const bench_t *b);
+
+/*
+ * bench_report
+ * ------------------------------
+ * printf one line of cycles per call for each of the
+ * n benchmarks, under a line with CCLK and the MAM mode.
+ */
+void bench_report(const bench_t *suite, U32 n);
+
+/*
+ * bench_mam_tune
+ * ------------------------------
+ * Time the suite under every MAM mode (0-2) and MAMTIM
+ * from hwSysMamtim(CCLK) to 7, leave the MAM at the
+ * fastest and return it as MAMCR << 4 | MAMTIM.
+ *
+ * A setting only counts if sig gives, BENCH_TRIES times,
+ * what it gave with the MAM off at MAMTIM 7: e.g. a CRC
+ * of a table in flash. MAMTIM is never set under the
+ * datasheet minimum, the tuner only picks among settings
+ * that are meant to work. Again after a CCLK change.
+ *
+ * Example:
+ *   U8 mam = bench_mam_tune(suite, n, flash_crc);
+ *   printf("MAMCR %u MAMTIM %u\n", mam >> 4, mam & 0x7);
+ */
+U8   bench_mam_tune(const bench_t *suite, U32 n, bench_sig_fn sig);
+
+#endif
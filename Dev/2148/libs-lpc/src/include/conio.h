@@ -1,27 +1,19 @@
 
 /*
- * lpc-serial.h
+ * conio.h
+ * -------------------------------------------
+ * Console names for UART0/UART1, on top of
+ * the port generic driver in lpc-uart.h
  */
 
-#ifndef _LPC_SERIAL_H
-#define _LPC_SERIAL_H
+#ifndef _CONIO_H
+#define _CONIO_H
 
 
-#include <math.h>
-
 #include "lpc214x.h"
 #include "types.h"
 #include "helpers.h"
-
-typedef enum {
-  TWELVE_B             = 1200,
-  FOURTY_EIGHT_B       = 4800,
-  NINETY_SIX_B         = 9600,
-  NINETEEN_TWO_B       = 19200,
-  THIRTY_EIGHT_FOUR_B  = 38400,
-  FIFTY_SEVEN_SIX_B    = 57600,
-  ONE_FIFTEEN_TWO_B    = 115200 
-} baud_t;
+#include "lpc-uart.h"
 
 #define MAXBUFFER                 120
 
@@ -30,8 +22,8 @@ typedef enum {
 #define U0RBR_EMPTY               !(U0LSR & 0x01)
 #define U0THRE_EMPTY               (U0LSR & 0x20) 
 
-#define U1RBR_EMPTY               !(U0LSR & 0x01)
-#define U1THRE_EMPTY               (U0LSR & 0x20) 
+#define U1RBR_EMPTY               !(U1LSR & 0x01)
+#define U1THRE_EMPTY               (U1LSR & 0x20) 
 //
 //
 #define U0LCR_DLAB_MASK           0x7F  
@@ -64,6 +56,7 @@ typedef enum {
 
 
 // FIFO (fcr)                   trig 000 txreset/rxreset Enable
+// also the fcr argument of uart_rx_trigger.
 #define U0FCR_EN_ONE_CHAR        0x7    // 00 000 00 1
 #define U0FCR_EN_FOUR_CHAR       0x41   // 01 000 00 1
 #define U0FCR_EN_EIGHT_CHAR      0x81   // 10 000 00 1
@@ -75,7 +68,6 @@ typedef enum {
 #define U1FCR_EN_FOURTEEN_CHAR   0xC1   // 11 000 00 1
 
 
-
 /*
  * console0Init
  * ---------------------------------------
@@ -89,7 +81,7 @@ void console0Init(baud_t baudRate);
 /*
  * console1Init
  * ---------------------------------------
- * Initialize the serial port for UART0
+ * Initialize the serial port for UART1
  *
  * Fix to 8N1 for simplicity.
  * Fix to one char for interrupt for simplicity.
@@ -97,6 +89,59 @@ void console0Init(baud_t baudRate);
 void console1Init(baud_t baudRate);
 
 
+/*
+ * console0TxBuffer
+ * ---------------------------------------
+ * Switch UART0 output to interrupt driven mode.
+ * putchar/puts copy into a UART_TXBUF_SIZE ring
+ * buffer and return; the THRE interrupt drains it.
+ * isr_vec is the VIC priority for UART0_Handler.
+ * policy selects what happens when the buffer is full.
+ * Call after console0Init.
+ *
+ * Example:
+ *   console0Init(ONE_FIFTEEN_TWO_B);
+ *   console0TxBuffer(2, TX_DROP_OLDEST);
+ */
+void console0TxBuffer(U16 isr_vec, txpolicy_t policy);
+
+/*
+ * console0TxFlush
+ * ---------------------------------------
+ * Wait until everything queued for UART0 has been
+ * handed to the UART. Safe with IRQs disabled.
+ */
+void console0TxFlush(void);
+
+/*
+ * console0TxDropped
+ * ---------------------------------------
+ * Number of chars discarded by TX_DROP_NEWEST or
+ * TX_DROP_OLDEST since console0TxBuffer.
+ */
+U32 console0TxDropped(void);
+
+/*
+ * console0RxBuffer
+ * ---------------------------------------
+ * Switch UART0 input to interrupt driven mode.
+ * The RX data available and character timeout
+ * interrupts move received chars into a
+ * UART_RXBUF_SIZE ring buffer, so nothing is lost
+ * while the main loop is busy.
+ * isr_vec is the VIC priority for UART0_Handler,
+ * ignored if console0TxBuffer already installed it.
+ */
+void console0RxBuffer(U16 isr_vec);
+
+/*
+ * console0RxOverruns
+ * ---------------------------------------
+ * Number of received chars lost because the ring
+ * buffer or the UART FIFO was full.
+ */
+U32 console0RxOverruns(void);
+
 /*
  * serial_getline
  * --------------------------------------
@@ -115,6 +160,40 @@ char* serial_getline (void);
  */
 char serial_getchar (void);
 
+/*
+ * serial_trygetchar
+ * --------------------------------------
+ * Return the next received char, or -1 if
+ * nothing is waiting. Never blocks.
+ */
+int serial_trygetchar (void);
+
+/*
+ * serial_getline_nb
+ * --------------------------------------
+ * Assemble received chars into line->buf until
+ * '\r' or '\n' (a "\r\n" pair ends one line).
+ * Gives up after roughly timeout_ms with no complete
+ * line; timeout_ms 0 only consumes what is already
+ * received. Empty lines are skipped.
+ *
+ * Returns the line length (terminator stripped,
+ * buffer '\0' terminated) and resets line for the
+ * next one, LINE_PENDING if the line is not complete
+ * yet, or LINE_OVERFLOW if it did not fit (the chars
+ * so far are discarded).
+ *
+ * Example:
+ *   static char cmd[64];
+ *   line_t      l;
+ *   line_init(&l, cmd, sizeof(cmd));
+ *   while(1) {
+ *       if(serial_getline_nb(&l, 0) > 0) run(cmd);
+ *       sample();
+ *   }
+ */
+int serial_getline_nb(line_t *line, U32 timeout_ms);
+
 /*
  * putchar
  * -------------------------------------
@@ -149,6 +228,13 @@ int putchar_u1(int output);
  */
 int puts(const char *s);
 
+/*
+ * puts_u1
+ * -------------------------------------
+ * put a string to the serial port uart1
+ */
+int puts_u1(const char *s);
+
 
 
 #endif
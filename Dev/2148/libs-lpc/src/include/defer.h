@@ -0,0 +1,71 @@
+
+/*
+ * defer.h
+ * -------------------------------------------
+ * Deferred work (bottom halves) for interrupt handlers.
+ *
+ * An ISR does the part that must be done now (read the
+ * peripheral, clear its flag) and posts the slow part,
+ * printing or flashing a led, with defer_post. The
+ * posted function runs later from the VIC software
+ * interrupt on DEFER_CHANNEL, attached nested at the
+ * lowest priority: it runs with IRQ enabled and every
+ * other interrupt preempts it.
+ *
+ * Posts run in order, one at a time, each to completion.
+ * Post from main or an IRQ handler, not from a FIQ.
+ *
+ * Example:
+ *   static void pressed(U32 n) { printf("press %u\n", n); }
+ *
+ *   void EINT0_Handler(void) {
+ *       EXTINT = 0x1;
+ *       defer_post(pressed, ++presses);
+ *       EXIT_INTERRUPT;
+ *   }
+ *   ...
+ *   defer_init(DEFER_PRIORITY);
+ */
+
+#ifndef _DEFER_H
+#define _DEFER_H
+
+#include "types.h"
+
+// reserved VIC channel on the LPC214x, raised by software only
+#define DEFER_CHANNEL        1
+
+// lowest priority for irq_attach
+#define DEFER_PRIORITY       255
+
+// queue entries, power of 2; one is kept empty
+#define DEFER_LEN            16
+
+typedef void (*defer_fn)(U32 arg);
+
+/*
+ * defer_init
+ * ------------------------------
+ * Empty the queue, attach the drain to DEFER_CHANNEL at
+ * priority. Returns the VIC slot, see irq_attach.
+ */
+int defer_init(U8 priority);
+
+/*
+ * defer_post
+ * ------------------------------
+ * Queue fn(arg) and raise the software interrupt.
+ * IRQ is off for a few instructions only.
+ * Returns 1, or 0 when the queue is full: the post
+ * is dropped and counted.
+ */
+int defer_post(defer_fn fn, U32 arg);
+
+/*
+ * defer_dropped
+ * ------------------------------
+ * Posts lost to a full queue since defer_init.
+ */
+U32 defer_dropped(void);
+
+#endif
@@ -10,10 +10,48 @@
 #ifndef _HELPERS_H
 #define _HELPERS_H
 
+#include <stdarg.h>
+#include <stddef.h>
+
+/*
+ * printf family (printf.c)
+ * -----------------------------------------------
+ * %d %i %u %x %X %o %c %s %p %f %%, flags '-' '0',
+ * width and precision ('*' too), 'l' (no-op, long
+ * is 32 bits) and 'll' (64 bit).
+ * %f is done with integer arithmetic only, no soft
+ * float printf gets linked: |values| < 2^64, at most
+ * 16 fraction digits, default 6.
+ * vsnprintf/snprintf return the length the whole
+ * output would have had, like C99.
+ * printf formats into a PRINTF_BUFLEN byte buffer on
+ * the stack and sends it with uart_write to
+ * PRINTF_PORT, one write per full buffer.
+ */
+#ifndef PRINTF_PORT
+#define PRINTF_PORT     0
+#endif
+#define PRINTF_BUFLEN   64
+
 int printf(const char *format, ...);
+int vprintf(const char *format, va_list args);
+int sprintf(char *buf, const char *format, ...);
+int snprintf(char *buf, size_t size, const char *format, ...);
+int vsnprintf(char *buf, size_t size, const char *format, va_list args);
 
+/*
+ * DBG_BINARY sends DBG output as lpc-log.h frames
+ * (format id + raw args) instead of formatting text
+ * on the target. Needs a string literal format in
+ * every DBG; decode with Tools/psas_logdecode.py.
+ */
 #ifdef DEBUG
+#ifdef DBG_BINARY
+#include "lpc-log.h"
+#define DBG     LOG
+#else
 #define DBG     printf
+#endif
 #define ASSERT(x)       if(!(x)){DBG("\nAssertion '%s' failed in %s:%s#%d!\n",#x,__FILE__,__FUNCTION__,__LINE__);while(1);}
 #else
 #define DBG(x ...)
@@ -21,23 +59,79 @@ int printf(const char *format, ...);
 #endif
 
 
+// enough for any 32 bit value in base 2 with sign and '\0'
+#define ITOA_BUFLEN      34
+
+/*
+ * utoa_r
+ * ------------------------------
+ * unsigned to ascii in base 2..16, written to buf
+ * ('\0' terminated). Reentrant. Base 10, 16, 8 and 2
+ * need no division (the ARM7TDMI has no divide
+ * instruction). buf needs ITOA_BUFLEN bytes for base 2,
+ * 11 for base 10, 9 for base 16.
+ *
+ * Returns the number of chars written, without the '\0'.
+ */
+int utoa_r(unsigned int val, char *buf, int base);
+
+/*
+ * itoa_r
+ * ------------------------------
+ * Like utoa_r for an int. Base 10 negative values
+ * get a '-'; other bases print the two's complement
+ * bits, as printf %x does.
+ */
+int itoa_r(int val, char *buf, int base);
+
 /*
  * itoa
  * ------------------------------
  * integer to ascii code
  * Copy return to a local variable for long
- * term useage.
+ * term useage. Not reentrant, use itoa_r from
+ * ISRs.
  */
 char* itoa(int val, int base);
 
 /*
  * ftoa
- * float to ascii code
+ * float to ascii code, printf "%f"
  * Copy return to a local var for long term usage
  */
-/*
 char* ftoa(float val);
-*/
+
+
+/*
+ * RAMFUNC
+ * ------------------------------
+ * Put a function in .fastcode: linked to run from RAM,
+ * copied there from flash by crt.s, no flash wait
+ * states or MAM misses. Use it on the prototype too.
+ *
+ * RAM is out of bl range of flash and binutils 2.19
+ * adds no veneers: RAMFUNC code must not call flash
+ * code directly (inline it, or call through a pointer).
+ * Flash code in other files calls it with a long call;
+ * gcc 4.2 ignores long_call for a function already
+ * defined in the same file, so there call it through a
+ * pointer or only from RAMFUNC code.
+ */
+#ifdef __arm__
+#define RAMFUNC         __attribute__ ((section(".fastcode"), long_call, noinline))
+#else
+#define RAMFUNC
+#endif
+
+/*
+ * memcpy_fast
+ * ------------------------------
+ * memcpy from RAM (RAMFUNC), four words a loop when
+ * dst and src are both word aligned. newlib's memcpy
+ * stays in flash: gcc calls it for struct copies with
+ * a plain bl.
+ */
+RAMFUNC void *memcpy_fast(void *dst, const void *src, size_t n);
 
 
 #define MINOF(a,b) ( ( (a) < (b) ) ? (a) : (b) )
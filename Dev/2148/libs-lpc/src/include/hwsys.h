@@ -3,6 +3,8 @@
 #ifndef _HWSYS_H
 #define _HWSYS_H
 
+#include "./types.h"
+
 /* 
  * Attempt to limit settings of frequency by using
  * C's limited type checking abilities. (i.e. Don't
@@ -16,14 +18,97 @@ typedef enum {
   SIXTY_MHZ       = 60000000 
 } freq_t;
 
+// crystal, Olimex LPC-P2148
+#ifndef HWSYS_FOSC
+#define HWSYS_FOSC          12000000
+#endif
+
 void	            hwSysInit(freq_t cclkFreq);
 
+/*
+ * hwSysInitClock
+ * ------------------------------
+ * Any CCLK and PCLK: programs the legal PLL0 and
+ * APBDIV setting closest to the targets (pll0_solve)
+ * and the MAMTIM for the CCLK it got (hwSysMamtim),
+ * MAM fully enabled. hwSysCclkVal and hwSysPclkVal
+ * give what was set. Returns FALSE, changing
+ * nothing, when fosc has no legal setting. Meant for
+ * boot, before the drivers start: no hwSysFreqNotify
+ * callbacks are made.
+ *
+ * Example, exact standard baud rates (PCLK 14.7456MHz,
+ * a 14.7456MHz crystal):
+ *   hwSysInitClock(14745600, 58982400, 14745600);
+ */
+bool                hwSysInitClock(U32 fosc, U32 cclk, U32 pclk);
+
+/*
+ * Clock changes after boot
+ * ------------------------------
+ * Drivers that load a divider from PCLK (the UARTs,
+ * the time base, the timer wheel, the RTC prescaler)
+ * register a callback when they start. hwSysSetFreq
+ * calls each with HWSYS_FREQ_PRE before PLL0 is
+ * touched, to finish what is in flight at the old
+ * clock, and HWSYS_FREQ_POST after, to load the
+ * dividers for the new one. cclk and pclk are the new
+ * clocks in both calls.
+ */
+#define HWSYS_FREQ_CALLBACKS    8
+
+typedef enum {
+  HWSYS_FREQ_PRE,
+  HWSYS_FREQ_POST
+} hwsys_phase_t;
+
+typedef void (*hwsys_freq_fn)(hwsys_phase_t phase, U32 cclk, U32 pclk);
+
+/*
+ * hwSysFreqNotify
+ * ------------------------------
+ * Register fn for clock changes; a second call with
+ * the same fn does nothing. FALSE when all
+ * HWSYS_FREQ_CALLBACKS are taken.
+ */
+bool                hwSysFreqNotify(hwsys_freq_fn fn);
+
+/*
+ * hwSysSetFreq
+ * ------------------------------
+ * Change CCLK and PCLK with the peripherals running:
+ * solves as hwSysInitClock (same crystal), then PRE
+ * callbacks, PLL0 disconnected, relocked and connected
+ * with the MAM timing for the new CCLK, POST callbacks.
+ * The MAM mode in place (e.g. bench_mam_tune's) is
+ * kept; only MAMTIM follows the CCLK.
+ * Call from main, not an ISR: the UART callback waits
+ * for the TX side to drain. A char received while the
+ * PLL relocks can be lost.
+ * Returns FALSE, changing nothing, when there is no
+ * legal setting.
+ *
+ * Example, slow down while idle:
+ *   hwSysSetFreq(12000000, 12000000);
+ *   ... wait for work ...
+ *   hwSysSetFreq(60000000, 60000000);
+ */
+bool                hwSysSetFreq(U32 cclk, U32 pclk);
+
+/*
+ * hwSysMamtim
+ * ------------------------------
+ * Flash access time in CCLKs for a CCLK, per the
+ * bands in hwsys.c: 1 under 20MHz, 2 to 40MHz, 3 above.
+ */
+U8                  hwSysMamtim(U32 cclk);
+
 inline int	    hwSysCclkVal(void);
 
 inline int          hwSysPclkVal(void);
 
 void IRQ_Routine (void)   __attribute__ ((interrupt("IRQ")));
-void FIQ_Routine (void)   __attribute__ ((interrupt("FIQ")));
+void FIQ_Routine (void);                 /* interrupts.c, see fiq_attach */
 void SWI_Routine (void)   __attribute__ ((interrupt("SWI")));
 void UNDEF_Routine (void) __attribute__ ((interrupt("UNDEF")));
 
@@ -19,6 +19,178 @@
 
 #define WATCHDOG_CHANNEL      0
 
+#define UART0_CHANNEL         6
+#define UART1_CHANNEL         7
+
+#define EINT0_CHANNEL         14
+#define EINT2_CHANNEL         16
+
+/*
+ * vic_channel_t
+ * ------------------------------
+ * Every LPC214x VIC source, the bit in the VIC
+ * registers. Reference: User manual LPC214x p50
+ * The XXX_CHANNEL defines above are the same numbers.
+ */
+typedef enum {
+  VIC_WDT               = 0,
+  VIC_SWI               = 1,       // software interrupts only
+  VIC_DBG_RX            = 2,       // ARM core EmbeddedICE
+  VIC_DBG_TX            = 3,
+  VIC_TIMER0            = 4,
+  VIC_TIMER1            = 5,
+  VIC_UART0             = 6,
+  VIC_UART1             = 7,
+  VIC_PWM0              = 8,
+  VIC_I2C0              = 9,
+  VIC_SPI0              = 10,
+  VIC_SPI1              = 11,      // SSP
+  VIC_PLL               = 12,
+  VIC_RTC               = 13,
+  VIC_EINT0             = 14,
+  VIC_EINT1             = 15,
+  VIC_EINT2             = 16,
+  VIC_EINT3             = 17,
+  VIC_AD0               = 18,
+  VIC_I2C1              = 19,
+  VIC_BOD               = 20,
+  VIC_AD1               = 21,      // LPC2144/6/8
+  VIC_USB               = 22       // LPC2146/8
+} vic_channel_t;
+
+/* VIC sources and vectored slots */
+#define IRQ_CHANNELS          32
+#define IRQ_SLOTS             16
+
+/* VICVectCntl: slot enabled, channel in bits 4:0 */
+#define VIC_SLOT_ENABLE       0x20
+
+/* irq_attach / irq_slot results besides 0..15 */
+#define IRQ_SLOT_NONE         -1
+#define IRQ_SLOT_DEFAULT      16       // non-vectored
+
+/*
+ * vic_enable, vic_disable, vic_pending, vic_force, vic_unforce
+ * ------------------------------
+ * One VIC register write or read each, inlined at -O0 too.
+ * The channel's handler is set with irq_attach (or the
+ * enableXXX_INT functions); vic_enable only unmasks it.
+ *
+ *   vic_pending   the raw request, enabled or not
+ *   vic_force     raise it from software (VICSoftInt),
+ *                 until vic_unforce
+ */
+static inline void vic_enable(vic_channel_t ch)  __attribute__((always_inline));
+static inline void vic_disable(vic_channel_t ch) __attribute__((always_inline));
+static inline U32  vic_pending(vic_channel_t ch) __attribute__((always_inline));
+static inline void vic_force(vic_channel_t ch)   __attribute__((always_inline));
+static inline void vic_unforce(vic_channel_t ch) __attribute__((always_inline));
+
+static inline void vic_enable(vic_channel_t ch) {
+    VICIntEnable = (0x1 << ch);
+}
+
+static inline void vic_disable(vic_channel_t ch) {
+    VICIntEnClr = (0x1 << ch);
+}
+
+static inline U32 vic_pending(vic_channel_t ch) {
+    return (VICRawIntr >> ch) & 0x1;
+}
+
+static inline void vic_force(vic_channel_t ch) {
+    VICSoftInt = (0x1 << ch);
+}
+
+static inline void vic_unforce(vic_channel_t ch) {
+    VICSoftIntClr = (0x1 << ch);
+}
+
+/* CPSR interrupt disable bits */
+#define IRQ_MASK 0x00000080
+#define FIQ_MASK 0x00000040
+#define INT_MASK (IRQ_MASK | FIQ_MASK)
+
+/*
+ * irq_save / irq_fiq_save / irq_restore
+ * ------------------------------
+ * Critical sections. irq_save masks IRQ, irq_fiq_save
+ * masks IRQ and FIQ; both return the CPSR they found.
+ * irq_restore puts back the mask bits of that CPSR, so
+ * a section inside another (or in a handler) leaves the
+ * interrupts as it found them. Inlined, 3 instructions
+ * in and 1 out, unlike the disableIRQ family.
+ *
+ * Use irq_fiq_save around feed sequences: any APB access
+ * between the two writes, a FIQ handler's too, spoils them.
+ *
+ * Example:
+ *   U32 cpsr = irq_save();
+ *   ...
+ *   irq_restore(cpsr);
+ */
+static inline U32  irq_save(void)          __attribute__((always_inline));
+static inline U32  irq_fiq_save(void)      __attribute__((always_inline));
+static inline void irq_restore(U32 cpsr)   __attribute__((always_inline));
+
+#ifdef __arm__
+static inline U32 irq_save(void) {
+    U32 cpsr, tmp;
+
+    asm volatile (" mrs  %0, cpsr\n"
+                  " orr  %1, %0, #0x80\n"
+                  " msr  cpsr_c, %1"
+                  : "=r" (cpsr), "=r" (tmp) : : "memory");
+    return cpsr;
+}
+
+static inline U32 irq_fiq_save(void) {
+    U32 cpsr, tmp;
+
+    asm volatile (" mrs  %0, cpsr\n"
+                  " orr  %1, %0, #0xC0\n"
+                  " msr  cpsr_c, %1"
+                  : "=r" (cpsr), "=r" (tmp) : : "memory");
+    return cpsr;
+}
+
+// the control byte: mode bits are unchanged inside a section
+static inline void irq_restore(U32 cpsr) {
+    asm volatile (" msr  cpsr_c, %0" : : "r" (cpsr) : "memory");
+}
+#else
+// host builds: the CPSR is a variable (interrupts.c) that
+// the simulator checks before it delivers an interrupt;
+// host_unmask (if set) takes what is pending when I or F
+// is cleared, as the core would
+extern U32 host_cpsr;
+extern void (*host_unmask)(void);
+
+static inline U32 irq_save(void) {
+    U32 cpsr = host_cpsr;
+
+    host_cpsr = cpsr | IRQ_MASK;
+    asm volatile ("" : : : "memory");
+    return cpsr;
+}
+
+static inline U32 irq_fiq_save(void) {
+    U32 cpsr = host_cpsr;
+
+    host_cpsr = cpsr | INT_MASK;
+    asm volatile ("" : : : "memory");
+    return cpsr;
+}
+
+static inline void irq_restore(U32 cpsr) {
+    U32 was = host_cpsr;
+
+    asm volatile ("" : : : "memory");
+    host_cpsr = (was & ~0xFF) | (cpsr & 0xFF);
+    if((was & ~cpsr & INT_MASK) && host_unmask) host_unmask();
+}
+#endif
+
 /*
  *
  * MACRO Name: ISR_ENTRY()
@@ -80,6 +252,7 @@
  * disableIRQ()
  * --------------------------------------------------------------
  *    This function sets the IRQ disable bit in the cpsr
+ *    (critical sections: irq_save is the inline form)
  *
  * Returns:
  *    previous value of CPSR
@@ -159,13 +332,158 @@ U32 restoreFIQ(U32 oldCPSR);
  */
 void update_VIC_table(U16 isr_vec, U32 isr, U8 isr_ctl);
 
+/*
+ * irq_attach
+ * ------------------------------
+ * Install int_handler for VIC channel [0:31] as an IRQ
+ * and enable the channel. Replaces an earlier handler
+ * of the same channel, the FIQ one too (fiq_detach).
+ *
+ * priority 0 is the highest. The 16 highest priority
+ * channels get the vectored slots in priority order,
+ * equal priorities in attach order; the rest are
+ * non-vectored and go through one dispatcher on
+ * VICDefVectAddr. Attaching or detaching a channel
+ * moves the channels behind it to the next slots.
+ *
+ * Returns the slot [0:15], IRQ_SLOT_DEFAULT when
+ * non-vectored, IRQ_SLOT_NONE for a bad channel.
+ *
+ * Example:
+ *   irq_attach(TIMER0_CHANNEL, (U32) TIMER0_Handler, 2);
+ */
+int irq_attach(U8 channel, U32 int_handler, U8 priority);
+
+/*
+ * irq_attach_nested
+ * ------------------------------
+ * irq_attach for a handler that may be preempted by
+ * higher priority IRQs. handler is a plain C function,
+ * NOT __attribute__((interrupt)), and must not write
+ * VICVectAddr (no EXIT_INTERRUPT): a stub runs it in
+ * System mode with IRQ enabled, FIQ as it was, and
+ * acknowledges the VIC when it returns. It must clear its peripheral's
+ * interrupt flag, as any handler does.
+ *
+ * Nesting uses 12 bytes of IRQ stack per level, the
+ * handlers run on the main (System mode) stack.
+ *
+ * Example:
+ *   void rtc_tick(void) { RESET_ILR; DBG("tick\n"); }
+ *   irq_attach_nested(RTC_CHANNEL, (U32) rtc_tick, 8);
+ */
+int irq_attach_nested(U8 channel, U32 handler, U8 priority);
+
+/*
+ * irq_detach
+ * ------------------------------
+ * Disable channel and give its slot back.
+ */
+void irq_detach(U8 channel);
+
+/*
+ * irq_slot
+ * ------------------------------
+ * Current slot of channel, as irq_attach returns it,
+ * or IRQ_SLOT_NONE when it is not attached.
+ */
+int irq_slot(U8 channel);
+
+/*
+ * fiq_attach
+ * ------------------------------
+ * Route channel to FIQ (VICIntSelect), with handler as
+ * the FIQ handler. One channel at a time: a second
+ * fiq_attach moves the FIQ to the new channel. The
+ * channel stops being an IRQ (irq_detach). Set up the
+ * peripheral first, e.g. with its enableXXX function.
+ * The F bit is left alone, as irq_attach leaves I: call
+ * enableFIQ once (crt.s starts main with FIQ off).
+ *
+ * handler is either a C function with
+ * __attribute__ ((interrupt("FIQ"))), which has the FIQ
+ * stack (crt.s FIQ_STACK_SIZE), or asm that keeps to the
+ * banked r8-r12 and needs no stack at all (fiq_capture).
+ * No VICVectAddr write is needed to leave a FIQ.
+ *
+ * Returns 0, or IRQ_SLOT_NONE for a bad channel.
+ */
+int fiq_attach(U8 channel, U32 handler);
+
+/*
+ * fiq_detach
+ * ------------------------------
+ * Disable the FIQ channel, back to the stub handler.
+ */
+void fiq_detach(void);
+
+/*
+ * fiq_load_banked
+ * ------------------------------
+ * Load the FIQ mode r8-r12 from regs[0..4], for a
+ * handler that keeps its state in them.
+ */
+void fiq_load_banked(const U32 regs[5]);
+
+/*
+ * fiq_capture
+ * ------------------------------
+ * Stock FIQ handler: store T1TC in fiq_capture_buf and
+ * clear the source, 8 instructions, no stack. Set up by
+ * fiq_capture_attach; timer1 must be running.
+ *
+ * Example: timestamp a trigger pulse on EINT2
+ *   enableEINT2(0, (U32) EINT2_Handler);    // pin and edge
+ *   fiq_capture_attach(EINT2_CHANNEL, (U32) &EXTINT, 0x4);
+ *   enableFIQ();
+ *   ...
+ *   while(fiq_capture_read(&t)) printf("%u\n", t);
+ */
+#define FIQ_CAPTURE_LEN       16       // power of 2
+#define FIQ_CAPTURE_MASK_S    "15"     // FIQ_CAPTURE_LEN - 1, for the asm
+
+typedef struct {
+    volatile U32 head;
+    volatile U32 stamp[FIQ_CAPTURE_LEN];
+} fiq_capture_t;
+
+extern fiq_capture_t fiq_capture_buf;
+
+void fiq_capture(void);
+
+/*
+ * fiq_capture_attach
+ * ------------------------------
+ * Put channel on FIQ with fiq_capture. flag_reg and
+ * flag_bit: the write that clears the interrupt
+ * (EXTINT and the EINT bit, TnIR and the match or
+ * capture bit).
+ */
+int fiq_capture_attach(U8 channel, U32 flag_reg, U32 flag_bit);
+
+/*
+ * fiq_capture_read
+ * ------------------------------
+ * Oldest stamp not read yet. Returns 0 when there is
+ * none. Older stamps are overwritten when more than
+ * FIQ_CAPTURE_LEN are waiting.
+ */
+int fiq_capture_read(U32 *stamp);
+
+/*
+ * The enableXXX_INT functions below attach through
+ * irq_attach with isr_vec as the priority, so the
+ * slots keep the order of the isr_vec values.
+ */
+
 /*
  * enableWATCHDOG_INT
  * ------------------------------
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
@@ -211,9 +529,10 @@ inline void disableWATCHDOG_INT(void) __attribute__((always_inline));
  * enableTIMER0_INT
  * ------------------------------
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
@@ -233,9 +552,10 @@ inline extern void disableTIMER0_INT(void){
  * enableTIMER1_INT
  * ------------------------------
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
@@ -255,9 +575,10 @@ inline void disableTIMER1_INT(void);
  * enableRTC_INT
  * ------------------------------
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
@@ -270,15 +591,62 @@ void enableRTC_INT(U16 isr_vec, U32 int_handler);
  */
 inline void disableRTC_INT(void);
 
+/*
+ * enableUART0_INT
+ * ------------------------------
+ * 
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
+ *
+ * int_handler is the address of the interrupt handler routine.
+ * The sources (RBR, THRE, RLS) are selected in U0IER by the caller.
+ */
+void enableUART0_INT(U16 isr_vec, U32 int_handler);
+
+/*
+ * disableUART0_INT
+ * ------------------------------
+ * 
+ */
+inline void disableUART0_INT(void);
+
+/*
+ * enableVIC_INT
+ * ------------------------------
+ * Generic form of the enableXXX_INT functions for
+ * drivers that serve several peripherals.
+ *
+ * channel is the VIC source number (UART0_CHANNEL...).
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
+ * (LPC23xx: every channel has its own vector and isr_vec
+ * is its priority [0:15]).
+ *
+ * int_handler is the address of the interrupt handler routine.
+ */
+void enableVIC_INT(U8 channel, U16 isr_vec, U32 int_handler);
+
+/*
+ * disableVIC_INT
+ * ------------------------------
+ * 
+ */
+void disableVIC_INT(U8 channel);
+
 /*
  * enableEINT0
  * ------------------------------
  * Sets the PINSEL1 Register for P0.16 to EINT0 mode
  * Enables the INT in the INT Enable register.
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  * int_handler is the address of the interrupt handler routine.
  */
 void enableEINT0(U16 isr_vec, U32 int_handler);
@@ -295,9 +663,10 @@ inline void disableEINT0(void);
  * Sets the PINSEL0 Register for P0.15 to EINT2 mode
  * Enables the INT in the INT Enable register.
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
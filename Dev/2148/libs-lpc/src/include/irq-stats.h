@@ -0,0 +1,91 @@
+
+/*
+ * irq-stats.h
+ * -------------------------------------------
+ * Interrupt latency and duration instrumentation.
+ *
+ * Opt in: build libs-lpc with -DIRQ_STATS. irq_attach
+ * then puts a per channel stub in front of each handler
+ * that reads IRQ_STATS_CLOCK on entry and exit and
+ * keeps, per channel, min / mean / max and a log2
+ * histogram (in clock ticks) of
+ *
+ *   latency   interrupt raised to handler entry. Only for
+ *             channels that know when that was: TIMER0 and
+ *             TIMER1 (from the match or capture register
+ *             that fired) or a source set with
+ *             irq_stats_latency.
+ *   duration  handler entry to exit, including the time
+ *             a nested handler spent preempted.
+ *
+ * The first IRQ_STATS_CHANNELS channels attached are
+ * tracked. Without -DIRQ_STATS nothing is wrapped and
+ * irq_stats_dump says so.
+ *
+ * Example:
+ *   irq_stats_init();                   // before the attaches
+ *   enableRTC_INT(13, (U32) RTC_Handler);
+ *   ...
+ *   if(serial_trygetchar() == 's') irq_stats_dump();
+ */
+
+#ifndef _IRQ_STATS_H
+#define _IRQ_STATS_H
+
+#include "types.h"
+#include "lpc214x.h"
+
+// free running clock: the low word of the time base
+// (lpc-timer.h), started by irq_stats_init if need be
+#ifndef IRQ_STATS_CLOCK
+#define IRQ_STATS_CLOCK          T1TC
+#endif
+
+#define IRQ_STATS_CHANNELS       8
+
+// bin k counts values in [2^k, 2^(k+1)), bin 0 also 0;
+// the last bin takes everything larger
+#define IRQ_STATS_BINS           20
+
+/*
+ * irq_stats_init
+ * ------------------------------
+ * Start the time base (timer1 at PCLK) unless it runs
+ * already, clear the stats.
+ */
+void irq_stats_init(void);
+
+/*
+ * irq_stats_clear
+ * ------------------------------
+ */
+void irq_stats_clear(void);
+
+/*
+ * irq_stats_latency
+ * ------------------------------
+ * Latency source for channel: a function, called on
+ * IRQ entry before the handler, returning clock ticks
+ * since the interrupt was raised (e.g. from a capture
+ * register). 0 turns latency off for the channel.
+ * The channel must have been attached.
+ */
+void irq_stats_latency(U8 channel, U32 (*since_raised)(void));
+
+/*
+ * irq_stats_dump
+ * ------------------------------
+ * printf a table of every tracked channel.
+ */
+void irq_stats_dump(void);
+
+/*
+ * irq_stats_wrap
+ * ------------------------------
+ * Used by irq_attach: the address to put in the VIC for
+ * handler on channel, the stats stub or handler itself
+ * when the table is full.
+ */
+U32 irq_stats_wrap(U8 channel, U32 handler);
+
+#endif
@@ -0,0 +1,105 @@
+
+/*
+ * lpc-gpio.h
+ * -------------------------------------------
+ * GPIO ports 0 and 1 through the fast registers.
+ *
+ * gpio_init sets SCS_GPIO0M and SCS_GPIO1M: the ports
+ * are then driven from the local bus, one cycle an
+ * access instead of an APB round trip, and the legacy
+ * IOnPIN/IOnSET/IOnCLR/IOnDIR no longer reach them.
+ * Everything that uses a pin goes through here (or
+ * FIOn* directly) after that.
+ *
+ * The calls take a mask of pins: set, clear, toggle
+ * and read touch those and no others, one or two
+ * register accesses each, inlined at -O0 too, and with
+ * a constant port the addresses are constants. FIOnMASK
+ * is left 0, so nothing here is a read-modify-write of
+ * the other pins: an ISR may drive pins of the same
+ * port at any time.
+ *
+ * Example, bit-banged clock on P0.4 with data on P0.5:
+ *   gpio_init();
+ *   gpio_output(0, (1 << 4) | (1 << 5));
+ *   for(k = 0; k < 8; ++k, b <<= 1) {
+ *       gpio_write(0, 1 << 5, (b & 0x80) ? 0xFFFFFFFF : 0);
+ *       gpio_toggle(0, 1 << 4);
+ *       gpio_toggle(0, 1 << 4);
+ *   }
+ */
+
+#ifndef _LPC_GPIO_H
+#define _LPC_GPIO_H
+
+#include "types.h"
+#include "lpc214x.h"
+
+#define FIO_BASE(p)       (0x3FFFC000 + 0x20 * (p))
+#define FIO_REG(p, off)   (*(volatile unsigned int *)(FIO_BASE(p) + (off)))
+
+#define FIO_DIR(p)        FIO_REG(p, 0x00)
+#define FIO_MASK(p)       FIO_REG(p, 0x10)
+#define FIO_PIN(p)        FIO_REG(p, 0x14)
+#define FIO_SET(p)        FIO_REG(p, 0x18)
+#define FIO_CLR(p)        FIO_REG(p, 0x1C)
+
+/*
+ * gpio_init
+ * ------------------------------
+ * Both ports to fast GPIO, keeping the direction and
+ * the level of every output. Once is enough, calling
+ * it again does nothing.
+ */
+void gpio_init(void);
+
+/*
+ * gpio_output / gpio_input
+ * ------------------------------
+ * Direction of the pins, with IRQ off around the
+ * FIOnDIR read-modify-write.
+ */
+void gpio_output(U8 port, U32 pins);
+void gpio_input(U8 port, U32 pins);
+
+/*
+ * gpio_set, gpio_clr, gpio_toggle, gpio_write, gpio_read
+ * ------------------------------
+ *   gpio_set      pins high, one write
+ *   gpio_clr      pins low, one write
+ *   gpio_toggle   each pin to the other level: one read,
+ *                 two writes
+ *   gpio_write    pins to the bits of value, two writes
+ *   gpio_read     the levels of pins, others 0
+ */
+static inline void gpio_set(U8 port, U32 pins)              __attribute__((always_inline));
+static inline void gpio_clr(U8 port, U32 pins)              __attribute__((always_inline));
+static inline void gpio_toggle(U8 port, U32 pins)           __attribute__((always_inline));
+static inline void gpio_write(U8 port, U32 pins, U32 value) __attribute__((always_inline));
+static inline U32  gpio_read(U8 port, U32 pins)             __attribute__((always_inline));
+
+static inline void gpio_set(U8 port, U32 pins) {
+    FIO_SET(port) = pins;
+}
+
+static inline void gpio_clr(U8 port, U32 pins) {
+    FIO_CLR(port) = pins;
+}
+
+static inline void gpio_toggle(U8 port, U32 pins) {
+    U32 now = FIO_PIN(port);
+
+    FIO_CLR(port) = now & pins;
+    FIO_SET(port) = ~now & pins;
+}
+
+static inline void gpio_write(U8 port, U32 pins, U32 value) {
+    FIO_SET(port) = value & pins;
+    FIO_CLR(port) = ~value & pins;
+}
+
+static inline U32 gpio_read(U8 port, U32 pins) {
+    return FIO_PIN(port) & pins;
+}
+
+#endif
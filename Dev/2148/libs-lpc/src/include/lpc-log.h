@@ -0,0 +1,70 @@
+
+/*
+ * lpc-log.h
+ * -------------------------------------------
+ * Deferred binary logging.
+ *
+ * LOG("fmt", args) does not format anything on the
+ * target. The format string goes into the .logfmt
+ * section, which the linker script keeps in the .out
+ * file but never loads into flash. At run time only a
+ * frame with the string's offset in .logfmt and the raw
+ * argument words is sent:
+ *
+ *   0xA5 | nargs | id (2 bytes LE) | nargs x U32 LE
+ *
+ * Tools/psas_logdecode.py reads the .out file and turns
+ * the frames back into text. Plain text output can be
+ * mixed in on the same port; it passes through.
+ *
+ * Limits: fmt must be a string literal, at most
+ * LOG_MAXARGS 32 bit arguments (no floats or long long).
+ * %s arguments are sent as pointers, the decoder expands
+ * them only when they point into flash (string literals).
+ *
+ * Example:
+ *   LOG("adc %d: %x\n", chan, val);
+ */
+
+#ifndef _LPC_LOG_H
+#define _LPC_LOG_H
+
+#include "types.h"
+
+// UART port the frames go to
+#ifndef LOG_PORT
+#define LOG_PORT                 0
+#endif
+
+#define LOG_SYNC                 0xA5
+#define LOG_MAXARGS              8
+
+/*
+ * LOG_NARGS
+ * Count the arguments after the format (0..LOG_MAXARGS).
+ */
+#define LOG_NARGS(args...)       LOG_NARGS_(0, ##args, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, rest...)  n
+
+/*
+ * LOG
+ * ------------------------------
+ * The format string's address in .logfmt is its id;
+ * .logfmt is linked at address 0 so the address is
+ * also the offset.
+ */
+#define LOG(fmt, args...)                                                   \
+    do {                                                                    \
+        static const char _logfmt[] __attribute__((section(".logfmt"))) = fmt; \
+        log_emit((U32) _logfmt, LOG_NARGS(args), ##args);                    \
+    } while(0)
+
+/*
+ * log_emit
+ * ------------------------------
+ * Send one frame: id and nargs U32 arguments.
+ * Called by LOG, not meant to be used directly.
+ */
+void log_emit(U32 id, U32 nargs, ...);
+
+#endif
@@ -34,6 +34,8 @@
  PREINT   1             1463    304
  PREFRAC  1             27648   5760
 
+ With SOURCE_PCLK, hwSysSetFreq recomputes both for
+ the new PCLK once this has been called.
 */
 void rtc_prescale(U16 iScale, U16 fScale);
 
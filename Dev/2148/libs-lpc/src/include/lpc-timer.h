@@ -47,5 +47,99 @@
 #define SET_CAPTURE_CONTROL_1(a) (T1CCR = a & 0x0FFF)
 
 
+/*
+ * Time base
+ * -------------------------------------------
+ * timer1 free running, extended to 64 bits by a match
+ * interrupt on MR3 at 0xFFFFFFFF: the last tick before
+ * TC wraps. The wrap itself is seen by the readers, so
+ * the time never steps back while that IRQ is pending.
+ *
+ * With prescale 0 and APBDIV 1 (hwSysInit) one tick is
+ * one CPU cycle, 2^32 of them are 71 s at 60 MHz.
+ * timer1 MR0-MR2 and the captures stay free to use, TC
+ * must not be reset or stopped. hwSysSetFreq keeps the
+ * tick rate when it can (a new prescale), else the
+ * count is rescaled: matches on timer1 are not.
+ *
+ * Example:
+ *   time_init(0);
+ *   t0 = time_now_cycles();
+ *   ...
+ *   printf("%llu cycles\n", time_now_cycles() - t0);
+ */
+
+// T1IR and T1MCR bits of the wrap match
+#define TIME_WRAP_IR          0x8
+#define TIME_WRAP_MCR         0x200
+
+// VIC priority of the wrap interrupt, once per 2^32 ticks
+#define TIME_PRIORITY         128
+
+/*
+ * time_init
+ * ------------------------------
+ * Start the time base at 0, counting PCLK / (prescale+1).
+ * Call after hwSysInit; attaches the timer1 IRQ.
+ */
+void time_init(U32 prescale);
+
+/*
+ * time_running
+ * ------------------------------
+ * TRUE after time_init.
+ */
+bool time_running(void);
+
+/*
+ * time_hz
+ * ------------------------------
+ * Ticks per second.
+ */
+U32  time_hz(void);
+
+/*
+ * time_now_cycles
+ * ------------------------------
+ * Ticks since time_init. Safe anywhere, main, IRQ and
+ * FIQ: IRQ and FIQ are off for the few instructions of
+ * the read.
+ */
+U64  time_now_cycles(void);
+
+/*
+ * time_now_us
+ * ------------------------------
+ * Microseconds since time_init. Uses 64 bit divisions,
+ * time_now_cycles is the cheap one to compare against.
+ */
+U64  time_now_us(void);
+
+/*
+ * delay_us / delay_ms
+ * ------------------------------
+ * Spin at least us (ms) on the time base, scaled from
+ * time_hz and rounded up to whole ticks: the same time
+ * at any CCLK and optimization level, longer by up to
+ * two ticks at a slow time_hz. Starts the time base
+ * (prescale 0) if it is not running.
+ */
+void delay_us(U32 us);
+void delay_ms(U32 ms);
+
+/*
+ * delay_ms_yield
+ * ------------------------------
+ * delay_ms calling yield() over and over while it waits,
+ * for polling work (a UART, a sensor) that must go on.
+ * The delay can end late by one yield() call.
+ *
+ * Example:
+ *   static void poll_rx(void) { ... serial_trygetchar() ... }
+ *   delay_ms_yield(1000, poll_rx);
+ */
+void delay_ms_yield(U32 ms, void (*yield)(void));
+
+
 
 #endif
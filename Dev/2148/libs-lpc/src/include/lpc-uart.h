@@ -0,0 +1,338 @@
+
+/*
+ * lpc-uart.h
+ * -------------------------------------------
+ * Port generic UART driver. One set of functions
+ * serves UART0/UART1 (LPC214x) and UART0-3 (LPC23xx);
+ * the port number selects the register block.
+ */
+
+#ifndef _LPC_UART_H
+#define _LPC_UART_H
+
+#include "types.h"
+#include "helpers.h"
+
+typedef enum {
+  TWELVE_B             = 1200,
+  FOURTY_EIGHT_B       = 4800,
+  NINETY_SIX_B         = 9600,
+  NINETEEN_TWO_B       = 19200,
+  THIRTY_EIGHT_FOUR_B  = 38400,
+  FIFTY_SEVEN_SIX_B    = 57600,
+  ONE_FIFTEEN_TWO_B    = 115200,
+  TWO_THIRTY_FOUR_B    = 230400,
+  FOUR_SIXTY_EIGHT_B   = 460800,
+  NINE_TWENTY_ONE_SIX_B = 921600
+} baud_t;
+
+/*
+ * Divisor settings for one baud rate:
+ *   baud = PCLK / (16 * dl * (1 + divaddval/mulval))
+ */
+typedef struct {
+  U16   dl;                 // DLM:DLL
+  U8    mulval;             // FDR bits 7:4, 1..15
+  U8    divaddval;          // FDR bits 3:0, < mulval
+  U32   baud;               // rate actually produced
+  U16   err;                // |baud - wanted| in 0.01% units
+} uart_div_t;
+
+// largest error uart_init treats as usable, 0.01% units (1%)
+#define UART_BAUD_ERR_MAX        100
+
+// slowest rate uart_baud_solve takes; DL tops out near
+// 57 baud at 60MHz PCLK anyway
+#define UART_BAUD_MIN            50
+
+#ifdef LPC23xx
+#define UART_NPORTS              4
+#else
+#define UART_NPORTS              2
+#endif
+
+// transmit ring buffer per port for interrupt driven output.
+// must be a power of 2.
+#ifndef UART_TXBUF_SIZE
+#define UART_TXBUF_SIZE          256
+#endif
+
+// receive ring buffer per port filled by the RX interrupt.
+// must be a power of 2.
+#ifndef UART_RXBUF_SIZE
+#define UART_RXBUF_SIZE          128
+#endif
+
+/*
+ * Register blocks. UART0 and UART1 sit at the same
+ * addresses on the LPC214x and LPC23xx.
+ */
+#define UART0_BASE               0xE000C000
+#define UART1_BASE               0xE0010000
+#define UART2_BASE               0xE0078000
+#define UART3_BASE               0xE007C000
+
+/*
+ * UART_BASE(p)
+ * The blocks are 0x4000 apart in pairs, so the
+ * address is plain arithmetic on the port: a constant
+ * port folds to a constant (UART_THR(0) costs the
+ * same as U0THR) and a variable one costs a shift.
+ */
+#ifdef LPC23xx
+#define UART_BASE(p)  (UART0_BASE + ((U32)(p) << 14) + ((U32)(p) >> 1) * 0x64000)
+#else
+#define UART_BASE(p)  (UART0_BASE + ((U32)(p) << 14))
+#endif
+
+#define UART_REG(p, off)  (*(volatile unsigned int *)(UART_BASE(p) + (off)))
+
+#define UART_RBR(p)       UART_REG(p, 0x00)
+#define UART_THR(p)       UART_REG(p, 0x00)
+#define UART_DLL(p)       UART_REG(p, 0x00)
+#define UART_DLM(p)       UART_REG(p, 0x04)
+#define UART_IER(p)       UART_REG(p, 0x04)
+#define UART_IIR(p)       UART_REG(p, 0x08)
+#define UART_FCR(p)       UART_REG(p, 0x08)
+#define UART_LCR(p)       UART_REG(p, 0x0C)
+#define UART_LSR(p)       UART_REG(p, 0x14)
+#define UART_FDR(p)       UART_REG(p, 0x28)
+
+// (lcr)
+#define ULCR_8N1                 0x03
+#define ULCR_DLAB                0x80
+
+// FIFO control (fcr)
+#define UFCR_FIFO_ENABLE         0x01
+#define UFCR_RX_RESET            0x02
+#define UFCR_TX_RESET            0x04
+#define UFCR_TRIGGER_MASK        0xC0
+
+// depth of the TX and RX hardware FIFOs
+#define UART_FIFO_LEN            16
+
+// Interrupt enable (ier)
+#define UIER_RBR                 0x1
+#define UIER_THRE                0x2
+#define UIER_RLS                 0x4
+
+// Interrupt identification (iir) bits 3:0
+#define UIIR_NO_INT              0x1
+#define UIIR_ID_MASK             0xE
+#define UIIR_THRE                0x2
+#define UIIR_RDA                 0x4
+#define UIIR_RLS                 0x6
+#define UIIR_CTI                 0xC
+
+// Line status (lsr)
+#define ULSR_RDR                 0x01
+#define ULSR_OE                  0x02
+#define ULSR_THRE                0x20
+#define ULSR_TEMT                0x40
+
+/*
+ * What a writer does when the transmit ring buffer is full.
+ */
+typedef enum {
+  TX_BLOCK,                 // wait for the ISR to make room
+  TX_DROP_NEWEST,           // discard the chars being written
+  TX_DROP_OLDEST            // discard the oldest queued chars
+} txpolicy_t;
+
+/*
+ * Caller owned line assembly state for uart_getline_nb.
+ * Set up with line_init; a partial line is kept across calls.
+ */
+typedef struct {
+  char *buf;
+  U16   size;               // bytes in buf, including the '\0'
+  U16   len;                // chars assembled so far
+  bool  cr;                 // last terminator was '\r'
+  bool  overflow;           // discarding until the next terminator
+} line_t;
+
+// uart_getline_nb return values (>0 is a line length)
+#define LINE_PENDING              0
+#define LINE_OVERFLOW            -1
+
+
+/*
+ * uart_baud_solve
+ * ---------------------------------------
+ * Integer search of DL, MULVAL and DIVADDVAL for the
+ * closest rate to baud from pclk. Honors the rule
+ * that DL must be 3 or more when DIVADDVAL > 0.
+ * Fills div with the best settings found and returns
+ * their error in 0.01% units, 0xFFFF for a baud below
+ * UART_BAUD_MIN.
+ *
+ * Example: 60MHz PCLK, 921600 baud
+ *   dl 3, mulval 14, divaddval 5: 921053 baud, err 5
+ *
+ * Reach at the hwSysInit PCLKs (err <= 16):
+ *   230400   12MHz and up
+ *   460800   24MHz and up
+ *   921600   48MHz and up
+ */
+U16 uart_baud_solve(U32 pclk, U32 baud, uart_div_t *div);
+
+/*
+ * uart_init
+ * ---------------------------------------
+ * Power up port, route its pins and set
+ * 8N1 at baudRate with the FIFOs enabled.
+ * The divisors come from uart_baud_solve at
+ * the current PCLK, and again at the new one
+ * after each hwSysSetFreq.
+ *
+ * Returns the baud rate error in 0.01% units;
+ * above UART_BAUD_ERR_MAX the link is unlikely
+ * to work (PCLK too slow for baudRate).
+ */
+U16 uart_init(U8 port, baud_t baudRate);
+
+/*
+ * uart_txbuffer
+ * ---------------------------------------
+ * Switch port output to interrupt driven mode.
+ * Writers copy into a UART_TXBUF_SIZE ring buffer
+ * and return; the THRE interrupt drains it a FIFO
+ * load at a time. isr_vec is the VIC priority for
+ * the port's handler (enableVIC_INT). policy selects
+ * what happens when the buffer is full. Call after
+ * uart_init; polled output still in the THR FIFO is
+ * waited out.
+ */
+void uart_txbuffer(U8 port, U16 isr_vec, txpolicy_t policy);
+
+/*
+ * uart_rxbuffer
+ * ---------------------------------------
+ * Switch port input to interrupt driven mode.
+ * The RX data available and character timeout
+ * interrupts move received chars into a
+ * UART_RXBUF_SIZE ring buffer.
+ * isr_vec is ignored if uart_txbuffer already
+ * installed the handler.
+ */
+void uart_rxbuffer(U8 port, U16 isr_vec);
+
+/*
+ * uart_txflush
+ * ---------------------------------------
+ * Wait until everything queued for port has been
+ * handed to the UART. Safe with IRQs disabled.
+ */
+void uart_txflush(U8 port);
+
+/*
+ * uart_txdropped
+ * ---------------------------------------
+ * chars discarded by TX_DROP_NEWEST or TX_DROP_OLDEST.
+ */
+U32 uart_txdropped(U8 port);
+
+/*
+ * uart_rxoverruns
+ * ---------------------------------------
+ * received chars lost because the ring buffer or
+ * the UART FIFO was full.
+ */
+U32 uart_rxoverruns(U8 port);
+
+/*
+ * uart_write
+ * -------------------------------------
+ * write len raw bytes (no '\n' translation).
+ * Loads up to UART_FIFO_LEN bytes per THRE, either
+ * by polling or through the ring buffer and THRE
+ * interrupt after uart_txbuffer.
+ *
+ * Returns the number of bytes accepted (less than
+ * len only under TX_DROP_NEWEST).
+ */
+U16 uart_write(U8 port, const char *buf, U16 len);
+
+/*
+ * uart_putchar
+ * -------------------------------------
+ * put a char, '\n' is sent as "\r\n".
+ */
+int uart_putchar(U8 port, int ch);
+
+/*
+ * uart_puts
+ * -------------------------------------
+ * put a string and a newline. Each run of
+ * text between newlines goes out as one burst.
+ */
+int uart_puts(U8 port, const char *s);
+
+/*
+ * uart_rx_trigger
+ * -------------------------------------
+ * set how many received chars raise the RX data
+ * available interrupt. fcr is one of the
+ * UxFCR_EN_*_CHAR values; fewer chars are still
+ * delivered by the character timeout interrupt.
+ *
+ * Example:
+ *   uart_rx_trigger(0, U0FCR_EN_FOURTEEN_CHAR);
+ */
+void uart_rx_trigger(U8 port, U8 fcr);
+
+/*
+ * uart_getchar
+ * --------------------------------------
+ * wait for and return a received char.
+ */
+char uart_getchar(U8 port);
+
+/*
+ * uart_trygetchar
+ * --------------------------------------
+ * Return the next received char, or -1 if
+ * nothing is waiting. Never blocks.
+ */
+int uart_trygetchar(U8 port);
+
+/*
+ * line_init
+ * --------------------------------------
+ * attach a caller buffer of size bytes to line.
+ */
+void line_init(line_t *line, char *buf, U16 size);
+
+/*
+ * uart_getline_nb
+ * --------------------------------------
+ * Assemble received chars into line->buf until
+ * '\r' or '\n' (a "\r\n" pair ends one line).
+ * Gives up after timeout_ms with no complete line,
+ * timed by the time base (time_init) when it runs and
+ * roughly otherwise; timeout_ms 0 only consumes what is
+ * already received. Empty lines are skipped.
+ *
+ * Returns the line length (terminator stripped,
+ * buffer '\0' terminated) and resets line for the
+ * next one, LINE_PENDING if the line is not complete
+ * yet, or LINE_OVERFLOW if it did not fit (the chars
+ * so far are discarded).
+ */
+int uart_getline_nb(U8 port, line_t *line, U32 timeout_ms);
+
+/*
+ * UARTn_Handler
+ * ---------------------------------------
+ * Per port interrupt entry, installed by
+ * uart_txbuffer or uart_rxbuffer. Run from RAM.
+ */
+RAMFUNC void UART0_Handler (void)   __attribute__ ((interrupt("IRQ")));
+RAMFUNC void UART1_Handler (void)   __attribute__ ((interrupt("IRQ")));
+#ifdef LPC23xx
+RAMFUNC void UART2_Handler (void)   __attribute__ ((interrupt("IRQ")));
+RAMFUNC void UART3_Handler (void)   __attribute__ ((interrupt("IRQ")));
+#endif
+
+
+#endif
@@ -11,18 +11,26 @@
 #define LED1_INDEX             10
 #define LED2_INDEX             11
 
-// Macros to use for turning on/off LEDs...
-// Need to know numbers of pins...
-#define LED1_ON         IOCLR0 = (1 << LED1_INDEX)
-#define LED2_ON         IOCLR0 = (1 << LED2_INDEX)
+// buzzer on P0.12 and P0.13
+#define BUZZER_PINS     0x00003000
+#define BUZZER_PIN      0x00001000
 
+// Macros to use for turning on/off LEDs, fast GPIO:
+// enable_leds first (it calls gpio_init)
+#define LED1_ON         FIO0CLR = (1 << LED1_INDEX)
+#define LED2_ON         FIO0CLR = (1 << LED2_INDEX)
 
-#define LED1_OFF        IOSET0 = (1 << LED1_INDEX)
-#define LED2_OFF        IOSET0 = (1 << LED2_INDEX)
 
+#define LED1_OFF        FIO0SET = (1 << LED1_INDEX)
+#define LED2_OFF        FIO0SET = (1 << LED2_INDEX)
 
-/* #define DEBUG_LED_ON(x)         IOCLR0 = (1 << x) */
-/* #define DEBUG_LED_OFF(x)        IOSET0 = (1 << x) */
+// flash_led on and off time, quiet time after a beep
+#define FLASH_MS        40
+#define BEEP_GAP_MS     100
+
+
+/* #define DEBUG_LED_ON(x)         FIO0CLR = (1 << x) */
+/* #define DEBUG_LED_OFF(x)        FIO0SET = (1 << x) */
 
 
 #include "lpc214x.h"
@@ -32,6 +40,7 @@
  * -------------------------------
  * enable the leds (1 and 2)
  * These are connected to P0.11 & P0.10
+ * Switches the ports to fast GPIO (gpio_init).
  */
 void enable_leds(void);
 
@@ -81,7 +90,7 @@ void led1_on(void);
  * turn off led2
  */
 inline extern void led2_off(void) {
-    IOSET0   |= (0x1 << 11);    // turn OFF led 2 (P0.11)
+    FIO0SET   = (0x1 << 11);    // turn OFF led 2 (P0.11)
 }
 
 /*
@@ -128,6 +137,7 @@ void beep_low();
  * beep_custom
  * ------------
  * use the buzzer to beep.
+ * halfperiod is in us: 500 periods of 2 * halfperiod.
  */
 void beep_custom(int halfperiod);
 
@@ -137,6 +147,7 @@ void beep_custom(int halfperiod);
  * waitCount
  * -----------------------
  * Spin in a loop for count ..
+ * Uncalibrated, use delay_us / delay_ms (lpc-timer.h).
  */
 void waitCount(int count);
 
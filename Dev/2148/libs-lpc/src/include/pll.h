@@ -10,6 +10,28 @@
 #include "./types.h"
 
 
+// PLL0 limits, LPC214x User Manual p39
+#define PLL_CCLK_MIN        10000000
+#define PLL_CCLK_MAX        60000000
+#define PLL_FCCO_MIN       156000000
+#define PLL_FCCO_MAX       320000000
+
+/*
+ * pll_config_t
+ * ----------------------
+ * One legal PLL0 and APBDIV setting, as pll0_solve
+ * found it: the register values and the clocks they
+ * give.
+ */
+typedef struct {
+    U8   msel;          // PLL0CFG MSEL, M - 1
+    U8   psel;          // PLL0CFG PSEL, P = 1 << psel
+    U8   apbdiv;        // VPBDIV: 1 PCLK = CCLK, 2 half, 0 quarter
+    U32  cclk;
+    U32  pclk;
+    U32  fcco;
+} pll_config_t;
+
 /*
  * pll0_feed
  * ----------------------
@@ -69,6 +91,25 @@ void pll0_feed(void);
 */
 void pll0_run(U8 psel, U8 msel, U8 apbdiv);
 
+/*
+ * pll0_solve
+ * ------------------------
+ * Find the PLL0 and APBDIV setting closest to a
+ * target CCLK and PCLK for crystal fosc, within
+ * PLL_CCLK_MIN..MAX and PLL_FCCO_MIN..MAX. Every M
+ * (1-32), P (1, 2, 4, 8) and APBDIV (1, 2, 4) is
+ * tried; the error is |CCLK - cclk| + |PCLK - pclk|,
+ * ties go to the lower CCLK, then the lower Fcco.
+ * Nothing is written to the PLL.
+ * Returns FALSE when no M gives a legal CCLK (fosc
+ * above 60 MHz or under 10 MHz / 32).
+ *
+ * Example, fosc 12MHz:
+ *   pll0_solve(12000000, 30000000, 15000000, &cfg)
+ *   cfg: M 2, P 4, APBDIV 2 => CCLK 24MHz, PCLK 12MHz
+ */
+bool pll0_solve(U32 fosc, U32 cclk, U32 pclk, pll_config_t *cfg);
+
 
 
 /*
@@ -0,0 +1,114 @@
+
+/*
+ * timer-wheel.h
+ * -------------------------------------------
+ * Software timers on timer0: any number of one shot
+ * timeouts, O(1) to start and cancel, on one match
+ * register.
+ *
+ * timer0 counts TW_HZ, or a little faster when PCLK is
+ * not a multiple of it (timer_wheel_hz): delays are
+ * converted, rounded up. Timers sit in a hierarchical
+ * wheel of TW_LEVELS levels of 32 slots by the highest
+ * 5 bit group in which their expiry differs from the
+ * wheel time; a slot of level l is moved down a level
+ * when the wheel time reaches it. MR0 is set to the
+ * next of these events only (tickless): with nothing
+ * due timer0 interrupts once per TW_IDLE ticks.
+ *
+ * Callbacks run in the timer0 IRQ handler with IRQ
+ * disabled: keep them short, defer_post the rest.
+ * A callback may start (restart) or cancel any timer.
+ *
+ * Example:
+ *   static swtimer_t blink;
+ *
+ *   static void blink_cb(swtimer_t *t) {
+ *       led1_invert();
+ *       timer_start(t, 500000, blink_cb);      // every 0.5 s
+ *   }
+ *   ...
+ *   timer_wheel_init();
+ *   timer_start(&blink, 500000, blink_cb);
+ */
+
+#ifndef _TIMER_WHEEL_H
+#define _TIMER_WHEEL_H
+
+#include "types.h"
+
+// delay units per second: delays are in us
+#define TW_HZ                1000000
+
+// VIC priority of timer0
+#define TW_PRIORITY          4
+
+// 5 bit levels over the 32 bit tick count
+#define TW_LEVELS            7
+#define TW_SLOTS             32
+
+// longest delay, and the idle interrupt period
+#define TW_MAX_DELAY         0x7FFFFFFF
+#define TW_IDLE              0x40000000
+
+typedef struct swtimer swtimer_t;
+typedef void (*swtimer_fn)(swtimer_t *t);
+
+struct swtimer {
+    swtimer_t   *next;
+    swtimer_t  **pprev;          // 0 when not started
+    U32          expires;        // timer0 tick
+    swtimer_fn   fn;
+    U32          arg;            // free for the caller
+    U8           level;
+    U8           slot;
+};
+
+/*
+ * timer_wheel_init
+ * ------------------------------
+ * Start timer0 at TW_HZ from PCLK, empty wheel, attach
+ * its IRQ. Call after hwSysInit; hwSysSetFreq sets the
+ * prescale again and, if the tick rate moves, scales
+ * the time left on the started timers.
+ */
+void timer_wheel_init(void);
+
+/*
+ * timer_start
+ * ------------------------------
+ * Call fn(t) delay us [1:TW_MAX_DELAY] from now.
+ * A started timer is moved to the new time.
+ */
+void timer_start(swtimer_t *t, U32 delay, swtimer_fn fn);
+
+/*
+ * timer_cancel
+ * ------------------------------
+ * Stop t if it is started.
+ */
+void timer_cancel(swtimer_t *t);
+
+/*
+ * timer_pending
+ * ------------------------------
+ * TRUE while t is started and has not fired.
+ */
+bool timer_pending(swtimer_t *t);
+
+/*
+ * timer_now
+ * ------------------------------
+ * timer0 ticks, wrapping at 2^32.
+ */
+U32 timer_now(void);
+
+/*
+ * timer_wheel_hz
+ * ------------------------------
+ * timer0 ticks per second: TW_HZ, or up to twice that
+ * when PCLK is not a multiple of it.
+ */
+U32 timer_wheel_hz(void);
+
+#endif
@@ -22,6 +22,7 @@ typedef        unsigned char          BYTE;  /* 8 bits  0-255           */
 typedef        unsigned char          U8  ;  /* 8 bits  0-255           */
 typedef        unsigned short int     U16 ;  /* 16 bits 0-65,535        */
 typedef        unsigned int           U32 ;  /* 32 bits 0-4,294,967,295 */
+typedef        unsigned long long     U64 ;  /* 64 bits                 */
 
 #define        U32MAX                 0xFFFFFFFF;
 #define        U32MIN                 0x00000000;
@@ -9,15 +9,12 @@
 #include "./include/types.h"
 #include "./lpc-timer.h"
 #include "./lpc-rtc.h"
+#include "./irq-stats.h"
 /*
  * working with the CPU
  *    http://www.ethernut.de/en/documents/arm-inline-asm.html
  */
 
-#define IRQ_MASK 0x00000080
-#define FIQ_MASK 0x00000040
-#define INT_MASK (IRQ_MASK | FIQ_MASK)
-
 #define EXT0FLAG              0x1
 #define EXT2FLAG              0x4
 
@@ -33,8 +30,6 @@
 #define EINT0_LEVEL_HI        0x1
 #define EINT2_LEVEL_HI        0x4
 
-#define EINT0_CHANNEL         14
-#define EINT2_CHANNEL         16
 
 #define EINT2_PINSEL0_MASK    0x3FFFFFFF  
 #define EINT0_PINSEL1_MASK    0xFFFFFFFC 
@@ -56,6 +51,7 @@
  * ---------------------------------------
  * Reads and returns the value of the cpsr
  */
+#ifdef __arm__
 static inline U32 __get_cpsr(void)
 {
     U32 retval;
@@ -68,6 +64,24 @@ static inline void __set_cpsr(U32 val)
 {
     asm volatile (" msr  cpsr, %0" : /* no outputs */ : "r" (val)  );	
 }
+#else
+// host builds: a variable, as crt.s enters main (SYS, I and F set)
+U32 host_cpsr = 0xDF;
+void (*host_unmask)(void);
+
+static inline U32 __get_cpsr(void)
+{
+    return host_cpsr;
+}
+
+static inline void __set_cpsr(U32 val)
+{
+    U32 was = host_cpsr;
+
+    host_cpsr = val;
+    if((was & ~val & INT_MASK) && host_unmask) host_unmask();
+}
+#endif
 
 
 /* The IRQ bit in the CPSR must be cleared for IRQ ints */
@@ -153,80 +167,597 @@ void update_VIC_table(U16 isr_vec, U32 isr, U8 isr_ctl) {
 	case 0:
 	    VICVectAddr0   = isr;
 	    VICVectCntl0   = isr_ctl;
+	    break;
 	case 1:
 	    VICVectAddr1   = isr;
 	    VICVectCntl1   = isr_ctl;
+	    break;
 	case 2:
 	    VICVectAddr2   = isr;
 	    VICVectCntl2   = isr_ctl;
+	    break;
 	case 3:
 	    VICVectAddr3   = isr;
 	    VICVectCntl3   = isr_ctl;
+	    break;
 	case 4:
 	    VICVectAddr4   = isr;
 	    VICVectCntl4   = isr_ctl;
+	    break;
 	case 5:
 	    VICVectAddr5   = isr;
 	    VICVectCntl5   = isr_ctl;
+	    break;
 	case 6:
 	    VICVectAddr6   = isr;
 	    VICVectCntl6   = isr_ctl;
+	    break;
 	case 7:
 	    VICVectAddr7   = isr;
 	    VICVectCntl7   = isr_ctl;
-
+	    break;
 	case 8:
 	    VICVectAddr8   = isr;
 	    VICVectCntl8   = isr_ctl;
+	    break;
 	case 9:
 	    VICVectAddr9   = isr;
 	    VICVectCntl9   = isr_ctl;
+	    break;
 	case 10:
 	    VICVectAddr10  = isr;
 	    VICVectCntl10  = isr_ctl;
+	    break;
 	case 11:
 	    VICVectAddr11  = isr;
 	    VICVectCntl11  = isr_ctl;
+	    break;
 	case 12:
 	    VICVectAddr12  = isr;
 	    VICVectCntl12  = isr_ctl;
+	    break;
 	case 13:
 	    VICVectAddr13  = isr;
 	    VICVectCntl13  = isr_ctl;
+	    break;
 	case 14:
 	    VICVectAddr14  = isr;
 	    VICVectCntl14  = isr_ctl;
+	    break;
 	case 15:
 	    VICVectAddr15  = isr;
 	    VICVectCntl15  = isr_ctl;
-	default:	    
-	    VICDefVectAddr = isr;       // non-vectored IRQ	    
+	    break;
+	default:
+	    VICDefVectAddr = isr;       // non-vectored IRQ
+	    break;
     }
 }
 
+/*
+ * VIC slot manager
+ * ------------------------------
+ * Every attached channel has an entry in irq_table, kept
+ * sorted by priority (0 first, equal priorities in attach
+ * order). The first IRQ_SLOTS entries own vectored slots
+ * 0..15 in that order, so the VIC's fixed slot priority
+ * is the requested priority and dispatch is the VIC's own
+ * VICVectAddr load. Entries past IRQ_SLOTS are non-vectored:
+ * irq_nonvect_dispatch (VICDefVectAddr) takes the lowest
+ * pending channel of irq_nonvect_mask with a de Bruijn
+ * lookup, no loop, and jumps to its handler.
+ *
+ * LPC23xx: one vector and priority register per channel,
+ * the table only supplies the handlers.
+ */
+typedef struct {
+    U32 handler;
+    U8  channel;
+    U8  priority;
+} irq_entry_t;
+
+static irq_entry_t irq_table[IRQ_CHANNELS];
+static U8          irq_count;
+
+// slot + 1 per channel, 0 when not attached
+static U8          irq_chan_slot[IRQ_CHANNELS];
+
+// the fiq_attach channel, IRQ_CHANNELS for none
+static U8          fiq_channel = IRQ_CHANNELS;
+
+// read by irq_nonvect_dispatch
+static U32         irq_nonvect_mask                      __attribute__((used));
+static U32         irq_nonvect_handler[IRQ_CHANNELS]     __attribute__((used));
+
+// bit number of a single set bit: table[(bit * 0x077CB531) >> 27]
+static const U8    irq_debruijn[32] __attribute__((used)) = {
+     0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+    31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+};
+
+void irq_nonvect_dispatch(void);
+void irq_spurious(void) __attribute__ ((interrupt("IRQ")));
+
+/*
+ * irq_nonvect_dispatch
+ * ------------------------------
+ * VICDefVectAddr target when channels are non-vectored.
+ * Entered straight from the IRQ vector, so it only uses
+ * r0-r2 (saved) and ends with a jump, not a call: the
+ * handler runs as if the VIC had vectored to it.
+ * In .fastcode, see RAMFUNC.
+ */
+#ifdef __arm__
+asm(
+"	.pushsection .fastcode, \"ax\", %progbits\n"
+"	.arm\n"
+"	.align	2\n"
+"	.global	irq_nonvect_dispatch\n"
+"irq_nonvect_dispatch:\n"
+"	sub	sp, sp, #4\n"                // room for the target
+"	stmfd	sp!, {r0-r2}\n"
+"	ldr	r0, =0xFFFFF000\n"           // VICIRQStatus
+"	ldr	r0, [r0]\n"
+"	ldr	r1, =irq_nonvect_mask\n"
+"	ldr	r1, [r1]\n"
+"	ands	r0, r0, r1\n"
+"	ldreq	r0, =irq_spurious\n"
+"	beq	1f\n"
+"	rsb	r1, r0, #0\n"
+"	and	r0, r0, r1\n"                // lowest pending bit
+"	ldr	r1, =0x077CB531\n"
+"	mul	r2, r0, r1\n"
+"	ldr	r1, =irq_debruijn\n"
+"	ldrb	r0, [r1, r2, lsr #27]\n"
+"	ldr	r1, =irq_nonvect_handler\n"
+"	ldr	r0, [r1, r0, lsl #2]\n"
+"1:	str	r0, [sp, #12]\n"
+"	ldmfd	sp!, {r0-r2, pc}\n"
+"	.ltorg\n"
+"	.popsection\n"
+);
+#else
+// same lookup in C, for host builds
+void irq_nonvect_dispatch(void) {
+    U32 pending = VICIRQStatus & irq_nonvect_mask;
+    U32 target  = (U32) irq_spurious;
+
+    if(pending) {
+        pending &= -pending;
+        target   = irq_nonvect_handler[irq_debruijn[(pending * 0x077CB531) >> 27]];
+    }
+    ((void (*)(void)) target)();
+}
+#endif
+
+/*
+ * irq_spurious
+ * ------------------------------
+ * Default vector with nothing non-vectored attached,
+ * or an IRQ that went away before it was read.
+ */
+void irq_spurious(void) {
+    EXIT_INTERRUPT;
+}
+
+/*
+ * irq_program
+ * ------------------------------
+ * Write irq_table to the VIC. Called with IRQ disabled.
+ */
+static void irq_program(void) {
+    U8  i, ch;
+    U32 nv = 0;
+
+    for(i = 0; i < IRQ_CHANNELS; ++i) irq_chan_slot[i] = 0;
+
+#ifdef LPC23xx
+    for(i = 0; i < irq_count; ++i) {
+        ch = irq_table[i].channel;
+        *(volatile U32 *)(0xFFFFF100 + 4 * ch) = irq_table[i].handler;
+        *(volatile U32 *)(0xFFFFF200 + 4 * ch) =
+            (irq_table[i].priority > 15) ? 15 : irq_table[i].priority;
+        irq_chan_slot[ch] = IRQ_SLOT_DEFAULT + 1;
+    }
+#else
+    for(i = 0; i < IRQ_SLOTS; ++i) {
+        if(i < irq_count) {
+            ch = irq_table[i].channel;
+            update_VIC_table(i, irq_table[i].handler, VIC_SLOT_ENABLE | ch);
+            irq_chan_slot[ch] = i + 1;
+        } else {
+            update_VIC_table(i, 0, 0);
+        }
+    }
+    for( ; i < irq_count; ++i) {
+        ch = irq_table[i].channel;
+        irq_nonvect_handler[ch] = irq_table[i].handler;
+        irq_chan_slot[ch]       = IRQ_SLOT_DEFAULT + 1;
+        nv |= 1 << ch;
+    }
+#endif
+    irq_nonvect_mask = nv;
+#ifndef LPC23xx
+    VICDefVectAddr   = nv ? (U32) irq_nonvect_dispatch : (U32) irq_spurious;
+#endif
+}
+
+/*
+ * irq_remove
+ * ------------------------------
+ * Take channel out of irq_table, if it is there.
+ */
+static void irq_remove(U8 channel) {
+    U8 i;
+
+    for(i = 0; i < irq_count; ++i) {
+        if(irq_table[i].channel == channel) {
+            --irq_count;
+            for( ; i < irq_count; ++i) irq_table[i] = irq_table[i + 1];
+            return;
+        }
+    }
+}
+
+/*
+ * irq_attach
+ * ------------------------------
+ */
+int irq_attach(U8 channel, U32 handler, U8 priority) {
+    U32 cpsr;
+    U8  i, j;
+
+    if(channel >= IRQ_CHANNELS || handler == 0) return IRQ_SLOT_NONE;
+
+    // the FIQ channel taken back as an IRQ: a later
+    // fiq_detach must not disable it
+    if(channel == fiq_channel) fiq_detach();
+
+    cpsr = irq_save();
+
+    vic_disable(channel);
+    irq_remove(channel);
+
+#ifdef IRQ_STATS
+    handler = irq_stats_wrap(channel, handler);
+#endif
+
+    // after every entry of the same or higher priority
+    for(i = 0; i < irq_count && irq_table[i].priority <= priority; ++i);
+    for(j = irq_count; j > i; --j) irq_table[j] = irq_table[j - 1];
+
+    irq_table[i].handler  = handler;
+    irq_table[i].channel  = channel;
+    irq_table[i].priority = priority;
+    ++irq_count;
+
+    irq_program();
+
+    VICIntSelect &= ~(1 << channel);
+    vic_enable(channel);
+
+    irq_restore(cpsr);
+
+    return irq_slot(channel);
+}
+
+/*
+ * irq_detach
+ * ------------------------------
+ */
+void irq_detach(U8 channel) {
+    U32 cpsr;
+
+    if(channel >= IRQ_CHANNELS) return;
+
+    cpsr = irq_save();
+
+    vic_disable(channel);
+    irq_remove(channel);
+    irq_program();
+
+    irq_restore(cpsr);
+}
+
+/*
+ * irq_slot
+ * ------------------------------
+ */
+int irq_slot(U8 channel) {
+    if(channel >= IRQ_CHANNELS) return IRQ_SLOT_NONE;
+    return (int) irq_chan_slot[channel] - 1;
+}
+
+/*
+ * Nested IRQs
+ * ------------------------------
+ * irq_attach_nested puts a per channel stub in the VIC
+ * instead of the handler. The stub saves the IRQ return
+ * state on the IRQ stack, switches to System mode with IRQ
+ * enabled, FIQ left as the interrupted code had it (a
+ * read-modify-write of CPSR: IRQ entry does not touch
+ * F), and calls the handler as a plain C function on
+ * the System (main) stack. The VIC still masks this and
+ * lower priority slots until VICVectAddr is written, so
+ * only higher priorities preempt. Back in IRQ mode with
+ * IRQ disabled the stub writes VICVectAddr and returns.
+ * The stubs are in .fastcode, see RAMFUNC.
+ *
+ *   IRQ stack:  r0, return address, spsr    (3 words a level)
+ *   SYS stack:  r1-r3, r12, lr + the handler's frame
+ */
+static U32 irq_nest_handler[IRQ_CHANNELS] __attribute__((used));
+
+#ifdef __arm__
+extern const U32 irq_nest_stubs[IRQ_CHANNELS];
+
+asm(
+"	.pushsection .fastcode, \"ax\", %progbits\n"
+"	.arm\n"
+"	.align	2\n"
+"	.irp	n, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+"irq_nest_stub_\\n:\n"
+"	sub	lr, lr, #4\n"
+"	stmfd	sp!, {r0, lr}\n"
+"	mov	r0, #\\n\n"
+"	b	irq_nest_common\n"
+"	.endr\n"
+"\n"
+"irq_nest_common:\n"
+"	mrs	lr, spsr\n"
+"	stmfd	sp!, {lr}\n"
+"	ldr	lr, =irq_nest_handler\n"
+"	ldr	r0, [lr, r0, lsl #2]\n"
+"	mrs	lr, cpsr\n"
+"	bic	lr, lr, #0x9F\n"            // IRQ on, F as it was
+"	orr	lr, lr, #0x1F\n"            // System mode
+"	msr	cpsr_c, lr\n"
+"	stmfd	sp!, {r1-r3, r12, lr}\n"
+"	mov	lr, pc\n"
+"	bx	r0\n"
+"	ldmfd	sp!, {r1-r3, r12, lr}\n"
+"	mrs	r0, cpsr\n"
+"	orr	r0, r0, #0x80\n"            // IRQ off
+"	bic	r0, r0, #0x1F\n"
+"	orr	r0, r0, #0x12\n"            // IRQ mode
+"	msr	cpsr_c, r0\n"
+"	ldr	r0, =0xFFFFF030\n"           // VICVectAddr
+"	str	r0, [r0]\n"
+"	ldmfd	sp!, {lr}\n"
+"	msr	spsr_cxsf, lr\n"
+"	ldmfd	sp!, {r0, pc}^\n"
+"	.ltorg\n"
+"\n"
+"	.pushsection .rodata\n"
+"	.align	2\n"
+"	.global	irq_nest_stubs\n"
+"irq_nest_stubs:\n"
+"	.irp	n, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+"	.word	irq_nest_stub_\\n\n"
+"	.endr\n"
+"	.popsection\n"
+"	.popsection\n"
+);
+#else
+// host builds: the same, with host_cpsr for the modes
+static void irq_nest_call(U8 channel) {
+    U32 cpsr = host_cpsr;
+
+    host_cpsr = (cpsr & ~0x9F) | 0x1F;
+    ((void (*)(void)) irq_nest_handler[channel])();
+    host_cpsr = cpsr;
+    VICVectAddr = 0;
+}
+
+#define IRQ_NEST_STUB(n)  static void irq_nest_stub_##n(void) { irq_nest_call(n); }
+IRQ_NEST_STUB(0)  IRQ_NEST_STUB(1)  IRQ_NEST_STUB(2)  IRQ_NEST_STUB(3)
+IRQ_NEST_STUB(4)  IRQ_NEST_STUB(5)  IRQ_NEST_STUB(6)  IRQ_NEST_STUB(7)
+IRQ_NEST_STUB(8)  IRQ_NEST_STUB(9)  IRQ_NEST_STUB(10) IRQ_NEST_STUB(11)
+IRQ_NEST_STUB(12) IRQ_NEST_STUB(13) IRQ_NEST_STUB(14) IRQ_NEST_STUB(15)
+IRQ_NEST_STUB(16) IRQ_NEST_STUB(17) IRQ_NEST_STUB(18) IRQ_NEST_STUB(19)
+IRQ_NEST_STUB(20) IRQ_NEST_STUB(21) IRQ_NEST_STUB(22) IRQ_NEST_STUB(23)
+IRQ_NEST_STUB(24) IRQ_NEST_STUB(25) IRQ_NEST_STUB(26) IRQ_NEST_STUB(27)
+IRQ_NEST_STUB(28) IRQ_NEST_STUB(29) IRQ_NEST_STUB(30) IRQ_NEST_STUB(31)
+
+static void (* const irq_nest_stubs[IRQ_CHANNELS])(void) = {
+    irq_nest_stub_0,  irq_nest_stub_1,  irq_nest_stub_2,  irq_nest_stub_3,
+    irq_nest_stub_4,  irq_nest_stub_5,  irq_nest_stub_6,  irq_nest_stub_7,
+    irq_nest_stub_8,  irq_nest_stub_9,  irq_nest_stub_10, irq_nest_stub_11,
+    irq_nest_stub_12, irq_nest_stub_13, irq_nest_stub_14, irq_nest_stub_15,
+    irq_nest_stub_16, irq_nest_stub_17, irq_nest_stub_18, irq_nest_stub_19,
+    irq_nest_stub_20, irq_nest_stub_21, irq_nest_stub_22, irq_nest_stub_23,
+    irq_nest_stub_24, irq_nest_stub_25, irq_nest_stub_26, irq_nest_stub_27,
+    irq_nest_stub_28, irq_nest_stub_29, irq_nest_stub_30, irq_nest_stub_31
+};
+#endif
+
+/*
+ * irq_attach_nested
+ * ------------------------------
+ */
+int irq_attach_nested(U8 channel, U32 handler, U8 priority) {
+
+    if(channel >= IRQ_CHANNELS || handler == 0) return IRQ_SLOT_NONE;
+
+    irq_nest_handler[channel] = handler;
+
+    return irq_attach(channel, (U32) irq_nest_stubs[channel], priority);
+}
+
+/*
+ * FIQ
+ * ------------------------------
+ * crt.s jumps to FIQ_Routine. That is one instruction in
+ * RAM (.data) that loads the pc from the word after it,
+ * fiq_handler_g, so fiq_attach can change the handler and
+ * the FIQ reaches it with two loads and no registers used.
+ * The banked r8-r12 are left to the handler.
+ */
+void fiq_unhandled(void) __attribute__ ((interrupt("FIQ")));
+void fiq_unhandled(void) {
+    while (1) ;
+}
+
+#ifdef __arm__
+extern U32 fiq_handler_g;
+
+asm(
+"	.pushsection .data\n"
+"	.arm\n"
+"	.align	2\n"
+"	.global	FIQ_Routine\n"
+"FIQ_Routine:\n"
+"	ldr	pc, fiq_handler_g\n"
+"	.global	fiq_handler_g\n"
+"fiq_handler_g:\n"
+"	.word	fiq_unhandled\n"
+"	.popsection\n"
+"\n"
+"	.pushsection .text\n"
+"	.arm\n"
+"	.align	2\n"
+"	.global	fiq_load_banked\n"
+"fiq_load_banked:\n"
+"	mrs	r1, cpsr\n"
+"	orr	r2, r1, #0xC0\n"             // IRQ and FIQ off
+"	bic	r2, r2, #0x1F\n"
+"	orr	r2, r2, #0x11\n"             // FIQ mode
+"	msr	cpsr_c, r2\n"
+"	ldmia	r0, {r8-r12}\n"
+"	msr	cpsr_c, r1\n"
+"	bx	lr\n"
+"\n"
+/*
+ * fiq_capture: r8 source flag register, r9 flag bit,
+ * r10 &fiq_capture_buf.stamp[0], r11 write index,
+ * r12 scratch. Stamps T1TC.
+ */
+"	.global	fiq_capture\n"
+"fiq_capture:\n"
+"	ldr	r12, =0xE0008008\n"          // T1TC
+"	ldr	r12, [r12]\n"
+"	str	r9, [r8]\n"                  // clear the source
+"	str	r12, [r10, r11, lsl #2]\n"
+"	add	r11, r11, #1\n"
+"	and	r11, r11, #" FIQ_CAPTURE_MASK_S "\n"
+"	str	r11, [r10, #-4]\n"           // fiq_capture_buf.head
+"	subs	pc, lr, #4\n"
+"	.ltorg\n"
+"	.popsection\n"
+);
+#else
+// host builds: the handler is called as a function
+U32 fiq_handler_g;
+
+void FIQ_Routine(void) {
+    if(fiq_handler_g) ((void (*)(void)) fiq_handler_g)();
+    else              fiq_unhandled();
+}
+
+void fiq_load_banked(const U32 regs[5]) {
+}
+
+void fiq_capture(void) {
+}
+#endif
+
+/*
+ * fiq_attach
+ * ------------------------------
+ */
+int fiq_attach(U8 channel, U32 handler) {
+    U32 cpsr;
+
+    if(channel >= IRQ_CHANNELS || handler == 0) return IRQ_SLOT_NONE;
+
+    irq_detach(channel);
+
+    cpsr = irq_fiq_save();
+    fiq_detach();
+
+    fiq_handler_g = handler;
+    fiq_channel   = channel;
+
+    VICIntSelect |= (1 << channel);
+    vic_enable(channel);
+
+    irq_restore(cpsr);
+
+    return 0;
+}
+
+/*
+ * fiq_detach
+ * ------------------------------
+ */
+void fiq_detach(void) {
+    U32 cpsr;
+
+    if(fiq_channel >= IRQ_CHANNELS) return;
+
+    cpsr = irq_fiq_save();
+
+    vic_disable(fiq_channel);
+    VICIntSelect &= ~(1 << fiq_channel);
+    fiq_handler_g = (U32) fiq_unhandled;
+    fiq_channel   = IRQ_CHANNELS;
+
+    irq_restore(cpsr);
+}
+
+/*
+ * fiq_capture
+ * ------------------------------
+ */
+fiq_capture_t fiq_capture_buf;
+
+static U32 fiq_capture_tail;
+
+int fiq_capture_attach(U8 channel, U32 flag_reg, U32 flag_bit) {
+    U32 regs[5];
+
+    fiq_capture_buf.head = 0;
+    fiq_capture_tail     = 0;
+
+    regs[0] = flag_reg;
+    regs[1] = flag_bit;
+    regs[2] = (U32) &fiq_capture_buf.stamp[0];
+    regs[3] = 0;
+    regs[4] = 0;
+    fiq_load_banked(regs);
+
+    return fiq_attach(channel, (U32) fiq_capture);
+}
+
+int fiq_capture_read(U32 *stamp) {
+    if(fiq_capture_tail == fiq_capture_buf.head) return 0;
+
+    *stamp = fiq_capture_buf.stamp[fiq_capture_tail];
+    fiq_capture_tail = (fiq_capture_tail + 1) & (FIQ_CAPTURE_LEN - 1);
+    return 1;
+}
+
+// enableXXX_INT isr_vec to an irq_attach priority,
+// clamped: a U16 cast would make 0x100 the highest
+#define ISR_VEC_PRIORITY(v)   ((U8) (((v) > 0xFF) ? 0xFF : (v)))
+
 /*
  * enableWATCHDOG_INT
  * ------------------------------
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
 void enableWATCHDOG_INT(U16 isr_vec, U32 int_handler) {
 
-    U8 watchdog_ctl = 0x00000020;
-
     disableWATCHDOG_INT();
 
-    update_VIC_table(isr_vec, int_handler, watchdog_ctl);
-  
-    // wdt selected for IRQ   
-    VICIntSelect &= ~(1 << WATCHDOG_CHANNEL);
-
-    VICIntEnable =   (1 << WATCHDOG_CHANNEL);
-
+    // wdt selected for IRQ
+    irq_attach(WATCHDOG_CHANNEL, int_handler, ISR_VEC_PRIORITY(isr_vec));
 }
 
 /*
@@ -236,34 +767,28 @@ void enableWATCHDOG_INT(U16 isr_vec, U32 int_handler) {
  */
 inline void disableWATCHDOG_INT(void) {
 
-    VICIntEnClr = (0x1 << TIMER0_CHANNEL);
+    vic_disable(WATCHDOG_CHANNEL);
 }
 
 /*
  * enableTIMER0_INT
  * ------------------------------
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
 void enableTIMER0_INT(U16 isr_vec, U32 int_handler) {
 
-    U8 timer0_ctl = 0x24;
-
     disableTIMER0_INT();
 
-    update_VIC_table(isr_vec, int_handler, timer0_ctl);
-
     RESET_T0IR;
 
-    // timer0   
-    VICIntSelect &= ~(1 << TIMER0_CHANNEL);
-
-    VICIntEnable =   (1 << TIMER0_CHANNEL);
-
+    // timer0
+    irq_attach(TIMER0_CHANNEL, int_handler, ISR_VEC_PRIORITY(isr_vec));
 }
 
 /*
@@ -273,34 +798,28 @@ void enableTIMER0_INT(U16 isr_vec, U32 int_handler) {
  */
 void disableTIMER0_INT(void) {
 
-    VICIntEnClr = (0x1 << TIMER0_CHANNEL);
+    vic_disable(TIMER0_CHANNEL);
 }
 
 /*
  * enableTIMER1_INT
  * ------------------------------
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
 void enableTIMER1_INT(U16 isr_vec, U32 int_handler) {
 
-    U8 timer1_ctl = 0x25;
-
     disableTIMER1_INT();
 
-    update_VIC_table(isr_vec, int_handler, timer1_ctl);
-
     RESET_T1IR;
 
-    // timer0   
-    VICIntSelect &= ~(1 << TIMER1_CHANNEL);
-
-    VICIntEnable =   (1 << TIMER1_CHANNEL);
-
+    // timer1
+    irq_attach(TIMER1_CHANNEL, int_handler, ISR_VEC_PRIORITY(isr_vec));
 }
 
 /*
@@ -310,35 +829,29 @@ void enableTIMER1_INT(U16 isr_vec, U32 int_handler) {
  */
 inline void disableTIMER1_INT(void) {
 
-    VICIntEnClr = (0x1 << TIMER1_CHANNEL);
+    vic_disable(TIMER1_CHANNEL);
 }
 
 /*
  * enableRTC_INT
  * ------------------------------
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  *
  * int_handler is the address of the interrupt handler routine.
  */
 void enableRTC_INT(U16 isr_vec, U32 int_handler) {
 
-    U8 rtc_ctl = 0x2D;               // channel 13 for rtc
-
     disableRTC_INT();
 
-    update_VIC_table(isr_vec, int_handler, rtc_ctl);
-
     // read and write the ILR to clear interrupt.
     RESET_ILR;
 
-    // rtc   
-    VICIntSelect &= ~(1 << RTC_CHANNEL);
-
-    VICIntEnable =   (1 << RTC_CHANNEL);
-
+    // rtc
+    irq_attach(RTC_CHANNEL, int_handler, ISR_VEC_PRIORITY(isr_vec));
 }
 
 /*
@@ -348,7 +861,63 @@ void enableRTC_INT(U16 isr_vec, U32 int_handler) {
  */
 inline void disableRTC_INT(void) {
 
-    VICIntEnClr = (0x1 << RTC_CHANNEL);
+    vic_disable(RTC_CHANNEL);
+}
+
+/*
+ * enableUART0_INT
+ * ------------------------------
+ * 
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
+ *
+ * int_handler is the address of the interrupt handler routine.
+ */
+void enableUART0_INT(U16 isr_vec, U32 int_handler) {
+
+    disableUART0_INT();
+
+    // uart0
+    irq_attach(UART0_CHANNEL, int_handler, ISR_VEC_PRIORITY(isr_vec));
+}
+
+/*
+ * disableUART0_INT
+ * ------------------------------
+ * 
+ */
+inline void disableUART0_INT(void) {
+
+    vic_disable(UART0_CHANNEL);
+}
+
+/*
+ * enableVIC_INT
+ * ------------------------------
+ * 
+ * channel is the VIC source number.
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
+ *
+ * int_handler is the address of the interrupt handler routine.
+ */
+void enableVIC_INT(U8 channel, U16 isr_vec, U32 int_handler) {
+
+    irq_attach(channel, int_handler, ISR_VEC_PRIORITY(isr_vec));
+}
+
+/*
+ * disableVIC_INT
+ * ------------------------------
+ * 
+ */
+void disableVIC_INT(U8 channel) {
+
+    vic_disable(channel);
 }
 
 /*
@@ -357,15 +926,14 @@ inline void disableRTC_INT(void) {
  * Sets the PINSEL1 Register for P0.16 to EINT0 mode
  * Enables the INT in the INT Enable register.
  * 
- * isr_vec is the 'slot' in the Vect. interrupt to assign
- * the vectored address to. [0:15]. Any other value results
- * in this being a non-vectored IRQ
+ * isr_vec is the irq_attach priority, 0 the highest;
+ * above 255 counts as 255. The channel is vectored
+ * while fewer than 16 attached channels rank before
+ * it, non-vectored otherwise.
  * int_handler is the address of the interrupt handler routine.
  */
 void enableEINT0(U16 isr_vec, U32 int_handler) {
 
-    U8 eint0_ctl = 0x2E;
-
     disableEINT0();                           // Disable EINT0
 
     // 01b is EINT0 mode, bits 1:0
@@ -384,13 +952,8 @@ void enableEINT0(U16 isr_vec, U32 int_handler) {
     // chaning EXT Registers may set an EXT flag.
     EXTINT   = EXT0FLAG;                          // Clear EINT0 Flag
 
-    update_VIC_table(isr_vec, int_handler, eint0_ctl);
-
-    // bit 1:0 of pinsel1 is P0.16  
-    VICIntSelect &= ~(1 << EINT0_CHANNEL);
-
-    VICIntEnable =   (1 << EINT0_CHANNEL);
-
+    // bit 1:0 of pinsel1 is P0.16
+    irq_attach(EINT0_CHANNEL, int_handler, ISR_VEC_PRIORITY(isr_vec));
 }
 
 /*
@@ -400,7 +963,7 @@ void enableEINT0(U16 isr_vec, U32 int_handler) {
  */
 inline void disableEINT0(void) {
 
-    VICIntEnClr = (0x1 << EINT0_CHANNEL);
+    vic_disable(EINT0_CHANNEL);
 }
 
 /*
@@ -409,8 +972,6 @@ inline void disableEINT0(void) {
  * olimex b1
  */
 void enableEINT2(U16 isr_vec, U32 int_handler) {
-    U32 eint2_ctl = 0x00000030;
-
     disableEINT2();                          // Disable EINT2
 
     // 10b is EINT mode, bits 31:30
@@ -428,11 +989,7 @@ void enableEINT2(U16 isr_vec, U32 int_handler) {
 
     EXTINT   = EXT2FLAG;                     // Clear the EINT2 interrupt flag
 
-    update_VIC_table(isr_vec, int_handler, eint2_ctl);
-
-    VICIntSelect &= ~(1 << EINT2_CHANNEL);   // IRQ
-
-    VICIntEnable =   (1 << EINT2_CHANNEL);   // Enable the EINT2 interrupt
+    irq_attach(EINT2_CHANNEL, int_handler, ISR_VEC_PRIORITY(isr_vec));   // Enable the EINT2 interrupt
 }
 
 /*
@@ -440,7 +997,7 @@ void enableEINT2(U16 isr_vec, U32 int_handler) {
  * ------------------------------
  */
 inline void disableEINT2(void) {
-    VICIntEnClr = (0x1 << EINT2_CHANNEL);
+    vic_disable(EINT2_CHANNEL);
 }
 
 /*
@@ -0,0 +1,306 @@
+
+/*
+ * irq-stats.c
+ * -------------------------------------------
+ * Interrupt latency and duration instrumentation,
+ * see irq-stats.h
+ */
+
+#include "./include/irq-stats.h"
+
+#include "lpc214x.h"
+#include "types.h"
+#include "helpers.h"
+#include "interrupts.h"
+#include "lpc-timer.h"
+
+typedef struct {
+    U32 count;
+    U32 min;
+    U32 max;
+    U64 sum;
+    U32 hist[IRQ_STATS_BINS];
+} irq_stat_t;
+
+typedef struct {
+    U8          channel;
+    U32         handler;
+    U32         entry;
+    U32       (*since_raised)(void);
+    irq_stat_t  lat;
+    irq_stat_t  dur;
+} irq_chan_stats_t;
+
+static irq_chan_stats_t irq_stats[IRQ_STATS_CHANNELS];
+static U8               irq_stats_n;
+
+// index + 1 per VIC channel, 0 when not tracked
+static U8               irq_stats_idx[IRQ_CHANNELS];
+
+/*
+ * timer latency
+ * ------------------------------
+ * Ticks since the match or capture that raised the
+ * interrupt, in PCLKs through the timer's prescaler,
+ * then in clock ticks: timer1's prescaler. With reset
+ * on match the TC itself is the time since the match.
+ * Host builds have no stubs to call them.
+ */
+#ifdef __arm__
+#define TIMER_REG(base, off)  (*(volatile U32 *)((base) + (off)))
+
+static U32 timer_since_raised(U32 base) {
+    U32 ir, tc, ticks, k;
+
+    ir = TIMER_REG(base, 0x00);
+    tc = TIMER_REG(base, 0x08);
+
+    for(k = 0; k < 4; ++k) {
+        if(ir & (1 << k)) {
+            if(TIMER_REG(base, 0x14) & (0x2 << (3 * k)))
+                ticks = tc;
+            else
+                ticks = tc - TIMER_REG(base, 0x18 + 4 * k);
+            break;
+        }
+        if(ir & (0x10 << k)) {
+            ticks = tc - TIMER_REG(base, 0x2C + 4 * k);
+            break;
+        }
+    }
+    if(k == 4) return 0;
+
+    return (ticks * (TIMER_REG(base, 0x0C) + 1) + TIMER_REG(base, 0x10)) / (T1PR + 1);
+}
+
+static U32 timer0_since_raised(void) {
+    return timer_since_raised(0xE0004000);
+}
+
+static U32 timer1_since_raised(void) {
+    return timer_since_raised(0xE0008000);
+}
+#endif
+
+/*
+ * stat_bin
+ * ------------------------------
+ * floor(log2(v)), by halves: no CLZ on the ARM7.
+ */
+static U32 stat_bin(U32 v) {
+    U32 b = 0;
+
+    if(v >= (1 << 16)) { b += 16; v >>= 16; }
+    if(v >= (1 << 8))  { b += 8;  v >>= 8;  }
+    if(v >= (1 << 4))  { b += 4;  v >>= 4;  }
+    if(v >= (1 << 2))  { b += 2;  v >>= 2;  }
+    if(v >= (1 << 1))  { b += 1; }
+
+    return (b < IRQ_STATS_BINS) ? b : IRQ_STATS_BINS - 1;
+}
+
+static void stat_add(irq_stat_t *s, U32 v) {
+    ++s->count;
+    s->sum += v;
+    if(v < s->min) s->min = v;
+    if(v > s->max) s->max = v;
+    ++s->hist[stat_bin(v)];
+}
+
+static void stat_clear(irq_stat_t *s) {
+    U32 k;
+
+    s->count = 0;
+    s->min   = 0xFFFFFFFF;
+    s->max   = 0;
+    s->sum   = 0;
+    for(k = 0; k < IRQ_STATS_BINS; ++k) s->hist[k] = 0;
+}
+
+/*
+ * irq_stats_enter / irq_stats_exit
+ * ------------------------------
+ * Called by the stub, IRQ mode with IRQ disabled.
+ * enter returns the real handler.
+ */
+U32 irq_stats_enter(U32 channel) {
+    irq_chan_stats_t *c = &irq_stats[irq_stats_idx[channel] - 1];
+
+    if(c->since_raised) stat_add(&c->lat, c->since_raised());
+
+    // stamp after the bookkeeping, it is not the handler's time
+    c->entry = IRQ_STATS_CLOCK;
+    return c->handler;
+}
+
+void irq_stats_exit(U32 channel) {
+    U32 now = IRQ_STATS_CLOCK;
+    irq_chan_stats_t *c = &irq_stats[irq_stats_idx[channel] - 1];
+
+    stat_add(&c->dur, now - c->entry);
+}
+
+/*
+ * Stubs
+ * ------------------------------
+ * One per channel. The handler is called as if the VIC
+ * had vectored to it: SPSR is set to this IRQ mode and
+ * lr so that its exception return (subs pc, lr, #4 or
+ * ldm ^) comes back here. Works for gcc interrupt("IRQ")
+ * functions and the irq_attach_nested stubs alike.
+ *
+ *   IRQ stack: channel, spsr, r0-r3, r12, return address
+ */
+#ifdef __arm__
+extern const U32 irq_stats_stubs[IRQ_CHANNELS];
+
+asm(
+"	.pushsection .text\n"
+"	.arm\n"
+"	.align	2\n"
+"	.irp	n, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+"irq_stats_stub_\\n:\n"
+"	sub	lr, lr, #4\n"
+"	stmfd	sp!, {r0-r3, r12, lr}\n"
+"	mov	r0, #\\n\n"
+"	b	irq_stats_common\n"
+"	.endr\n"
+"\n"
+"irq_stats_common:\n"
+"	mrs	r1, spsr\n"
+"	stmfd	sp!, {r0, r1}\n"
+"	bl	irq_stats_enter\n"
+"	mrs	r1, cpsr\n"
+"	msr	spsr_cxsf, r1\n"
+"	add	lr, pc, #4\n"                // handler returns to lr - 4: the ldr
+"	bx	r0\n"
+"	ldr	r0, [sp]\n"
+"	bl	irq_stats_exit\n"
+"	ldmfd	sp!, {r0, r1}\n"
+"	msr	spsr_cxsf, r1\n"
+"	ldmfd	sp!, {r0-r3, r12, pc}^\n"
+"\n"
+"	.pushsection .rodata\n"
+"	.align	2\n"
+"	.global	irq_stats_stubs\n"
+"irq_stats_stubs:\n"
+"	.irp	n, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31\n"
+"	.word	irq_stats_stub_\\n\n"
+"	.endr\n"
+"	.popsection\n"
+"	.popsection\n"
+);
+#endif
+
+/*
+ * irq_stats_wrap
+ * ------------------------------
+ */
+U32 irq_stats_wrap(U8 channel, U32 handler) {
+#ifdef __arm__
+    irq_chan_stats_t *c;
+
+    if(irq_stats_idx[channel] == 0) {
+        if(irq_stats_n >= IRQ_STATS_CHANNELS) return handler;
+
+        c = &irq_stats[irq_stats_n++];
+        irq_stats_idx[channel] = irq_stats_n;
+
+        c->channel = channel;
+        stat_clear(&c->lat);
+        stat_clear(&c->dur);
+        if(channel == TIMER0_CHANNEL)      c->since_raised = timer0_since_raised;
+        else if(channel == TIMER1_CHANNEL) c->since_raised = timer1_since_raised;
+        else                               c->since_raised = 0;
+    }
+    irq_stats[irq_stats_idx[channel] - 1].handler = handler;
+
+    return irq_stats_stubs[channel];
+#else
+    // host builds: no stubs
+    return handler;
+#endif
+}
+
+/*
+ * irq_stats_latency
+ * ------------------------------
+ */
+void irq_stats_latency(U8 channel, U32 (*since_raised)(void)) {
+    if(channel >= IRQ_CHANNELS || irq_stats_idx[channel] == 0) return;
+
+    irq_stats[irq_stats_idx[channel] - 1].since_raised = since_raised;
+}
+
+/*
+ * irq_stats_clear
+ * ------------------------------
+ */
+void irq_stats_clear(void) {
+    U32 cpsr, i;
+
+    cpsr = irq_save();
+    for(i = 0; i < irq_stats_n; ++i) {
+        stat_clear(&irq_stats[i].lat);
+        stat_clear(&irq_stats[i].dur);
+    }
+    irq_restore(cpsr);
+}
+
+/*
+ * irq_stats_init
+ * ------------------------------
+ */
+void irq_stats_init(void) {
+    if(!time_running()) time_init(0);
+
+    irq_stats_clear();
+}
+
+#ifdef IRQ_STATS
+/*
+ * stat_print
+ * ------------------------------
+ */
+static void stat_print(const char *name, irq_stat_t *s) {
+    U32 k;
+
+    if(s->count == 0) {
+        printf("  %s  -\n", name);
+        return;
+    }
+    printf("  %s  min %u  mean %u  max %u\n", name,
+           s->min, (U32) (s->sum / s->count), s->max);
+
+    printf("      ");
+    for(k = 0; k < IRQ_STATS_BINS; ++k) {
+        if(s->hist[k]) printf(" 2^%u:%u", k, s->hist[k]);
+    }
+    printf("\n");
+}
+#endif
+
+/*
+ * irq_stats_dump
+ * ------------------------------
+ * Copies each channel with IRQ off, prints with IRQ on.
+ */
+void irq_stats_dump(void) {
+#ifndef IRQ_STATS
+    printf("irq stats: off, build libs-lpc with -DIRQ_STATS\n");
+#else
+    irq_chan_stats_t c;
+    U32 cpsr, i;
+
+    printf("irq stats, clock ticks (%u Hz)\n", time_hz());
+    for(i = 0; i < irq_stats_n; ++i) {
+        cpsr = irq_save();
+        c = irq_stats[i];
+        irq_restore(cpsr);
+
+        printf("ch %2u  %u calls\n", c.channel, c.dur.count);
+        stat_print("lat", &c.lat);
+        stat_print("dur", &c.dur);
+    }
+#endif
+}
@@ -0,0 +1,64 @@
+/*
+ * lpc-gpio.c
+ * -------------------------------------------
+ * Fast GPIO, see lpc-gpio.h
+ */
+
+#include "./include/lpc-gpio.h"
+
+#include "lpc214x.h"
+#include "types.h"
+#include "interrupts.h"
+
+/*
+ * gpio_init
+ * ------------------------------
+ * IOnPIN reads an output's level back, that is its
+ * latch: written to FIOnSET/FIOnCLR before FIOnDIR,
+ * so no output glitches on the switch.
+ */
+void gpio_init(void) {
+    U32 cpsr, dir0, dir1, out0, out1;
+
+    if((SCS & (SCS_GPIO0M | SCS_GPIO1M)) == (SCS_GPIO0M | SCS_GPIO1M)) return;
+
+    cpsr = irq_save();
+
+    dir0 = IO0DIR;
+    dir1 = IO1DIR;
+    out0 = IO0PIN & dir0;
+    out1 = IO1PIN & dir1;
+
+    SCS |= SCS_GPIO0M | SCS_GPIO1M;
+
+    FIO0MASK = 0;
+    FIO1MASK = 0;
+    FIO0SET  = out0;
+    FIO0CLR  = ~out0 & dir0;
+    FIO1SET  = out1;
+    FIO1CLR  = ~out1 & dir1;
+    FIO0DIR  = dir0;
+    FIO1DIR  = dir1;
+
+    irq_restore(cpsr);
+}
+
+/*
+ * gpio_output / gpio_input
+ * ------------------------------
+ */
+void gpio_output(U8 port, U32 pins) {
+    U32 cpsr;
+
+    cpsr = irq_save();
+    FIO_DIR(port) |= pins;
+    irq_restore(cpsr);
+}
+
+void gpio_input(U8 port, U32 pins) {
+    U32 cpsr;
+
+    cpsr = irq_save();
+    FIO_DIR(port) &= ~pins;
+    irq_restore(cpsr);
+}
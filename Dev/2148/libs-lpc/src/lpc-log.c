@@ -0,0 +1,49 @@
+
+/*
+ * lpc-log.c
+ * -------------------------------------------
+ * Deferred binary logging, see lpc-log.h
+ */
+
+#include <stdarg.h>
+
+#include "./include/lpc-log.h"
+
+#include "types.h"
+#include "lpc-uart.h"
+
+/*
+ * log_emit
+ * ------------------------------
+ * Build the whole frame first so it goes out as
+ * one uart_write (one FIFO burst or one ring buffer
+ * copy). With the port buffered (uart_txbuffer)
+ * and room in the ring, a frame from an ISR cannot
+ * land inside a frame from the main loop.
+ */
+void log_emit(U32 id, U32 nargs, ...) {
+    va_list ap;
+    char    frame[4 + 4 * LOG_MAXARGS];
+    char   *p;
+    U32     arg;
+
+    if(nargs > LOG_MAXARGS) nargs = LOG_MAXARGS;
+
+    frame[0] = LOG_SYNC;
+    frame[1] = nargs;
+    frame[2] = id & 0xFF;
+    frame[3] = (id >> 8) & 0xFF;
+    p        = &frame[4];
+
+    va_start(ap, nargs);
+    while(nargs--) {
+        arg  = va_arg(ap, U32);
+        *p++ = arg & 0xFF;
+        *p++ = (arg >> 8) & 0xFF;
+        *p++ = (arg >> 16) & 0xFF;
+        *p++ = (arg >> 24) & 0xFF;
+    }
+    va_end(ap);
+
+    uart_write(LOG_PORT, frame, p - frame);
+}
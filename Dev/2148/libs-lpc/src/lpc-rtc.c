@@ -11,6 +11,7 @@
 
 #include "types.h"
 #include "lpc214x.h"
+#include "hwsys.h"
 
 #include "lpc-serial.h"
 #include "helpers.h"
@@ -18,6 +19,8 @@
 // declare prototype.
 U8 _month_map(U16 year, U8 month);
 
+static void rtc_retime(hwsys_phase_t phase, U32 cclk, U32 pclk);
+
 
 /*
  * rtc_prescale
@@ -43,6 +46,24 @@ void rtc_prescale(U16 iScale, U16 fScale) {
     PREINT = iScale & int_mask;
     PREFRAC= fScale & frac_mask;
 
+    hwSysFreqNotify(rtc_retime);
+}
+
+/*
+ * rtc_retime
+ * -----------------------------
+ * hwSysSetFreq callback: the prescaler for the new
+ * PCLK, by the formulas above. Nothing to do when
+ * the RTC runs from the 32kHz crystal.
+ */
+static void rtc_retime(hwsys_phase_t phase, U32 cclk, U32 pclk) {
+    U32 iScale;
+
+    if(phase != HWSYS_FREQ_POST || (CCR & (SOURCE_RTCX << 4))) return;
+
+    iScale = pclk / 32768 - 1;
+    PREINT = iScale & 0x1FFF;
+    PREFRAC= (pclk - (iScale + 1) * 32768) & 0x7FFF;
 }
 
 /*
@@ -13,11 +13,8 @@
 #include "./include/types.h"
 #include "./include/lpc214x.h"
 
-#define MAXBUFFER                 120
-
 // define these for readablity.
 
-#define U0RBR_EMPTY               !(U0LSR & 0x01)
 #define U0THRE_EMPTY               (U0LSR & 0x20) 
 
 #define U0LCR_DLAB_MASK           0x7F  
@@ -72,45 +69,13 @@ void serial0Init(U16 divisor, U8 lcr, U8 fcr) {
 }    
 
 /*
- * serial_getline
+ * serial_getline, serial_getchar
  * --------------------------------------
- * receive chars from the serial port until
- * \n, then return a string.
- * Maximum length of line is 120 chars.
- * copy string from pointer to new variable,
- * static declaration here is to avoid global declaration.
- * HOWEVER, the pointer is globally accessed too...shrug.
+ * Implemented once in conio.c (polled or, after
+ * console0RxBuffer, from the interrupt driven
+ * ring buffer). Duplicate copies here collided
+ * with conio.o in liblpc.a.
  */
-char* serial_getline (void)  {
- 
-    char current=' ';
-    U16 index=0;
-    static char _LINEBUFFER[MAXBUFFER];
-
-//    while(current != '\r' && index < MAXBUFFER-1) {
-    while(current != '\n' && index < MAXBUFFER-1) {
-	current=serial_getchar();
-	_LINEBUFFER[index]=current;
-	++index;
-    }
-    _LINEBUFFER[index]='\0';
-
-    return (_LINEBUFFER);
-}
-
-
-/*
- * serial_getchar
- * --------------------------------------
- * receive a char from the serial port
- * Return a char (U8).
- */
-char serial_getchar (void)  {
-  
-    while (U0RBR_EMPTY);
-
-    return (U0RBR);
-}
 
 
 
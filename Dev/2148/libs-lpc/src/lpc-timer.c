@@ -1,6 +1,213 @@
-
 /*
  * lpc-timer.c
  */
 
 #include "./include/lpc-timer.h"
+
+#include "types.h"
+#include "lpc214x.h"
+#include "hwsys.h"
+#include "helpers.h"
+#include "interrupts.h"
+
+// ticks above 2^32, and the rate they are counted at
+static volatile U32 time_hi;
+static U32          time_rate;
+
+/*
+ * TIMER1_Wrap
+ * ------------------------------
+ * TC is at 0xFFFFFFFF, for PR + 1 PCLKs, and may still
+ * be: time_now_cycles sorts that out. The flag is
+ * cleared with hi counted in one step for the readers,
+ * a FIQ too. Runs from RAM.
+ */
+RAMFUNC static void TIMER1_Wrap(void) __attribute__ ((interrupt("IRQ")));
+RAMFUNC static void TIMER1_Wrap(void) {
+    U32 cpsr;
+
+    cpsr = irq_fiq_save();
+    ++time_hi;
+    T1IR = TIME_WRAP_IR;
+    irq_restore(cpsr);
+
+    EXIT_INTERRUPT;
+}
+
+static void time_retime(hwsys_phase_t phase, U32 cclk, U32 pclk);
+
+/*
+ * time_init
+ * ------------------------------
+ */
+void time_init(U32 prescale) {
+
+    disableTIMER1_INT();
+
+    DISABLE_TIMER1;
+    SET_T1CTCR(0x0);
+    SET_PRESCALE1(prescale);
+    T1MR3 = 0xFFFFFFFF;
+    T1MCR = (T1MCR & ~0xE00) | TIME_WRAP_MCR;
+    RESET_TIMER1;
+    T1IR  = TIME_WRAP_IR;
+
+    time_hi   = 0;
+    time_rate = hwSysPclkVal() / (prescale + 1);
+
+    irq_attach(TIMER1_CHANNEL, (U32) TIMER1_Wrap, TIME_PRIORITY);
+    hwSysFreqNotify(time_retime);
+
+    ENABLE_TIMER1;
+}
+
+/*
+ * time_retime
+ * ------------------------------
+ * hwSysSetFreq callback. The tick rate stays when the
+ * new PCLK is a multiple of it, with a new prescale;
+ * otherwise it becomes PCLK / (prescale + 1) and the
+ * count is scaled to it, so time_now_us goes on. Ticks
+ * counted while PLL0 relocked (PCLK from the crystal)
+ * pass for old rate ones: time can slip by about the
+ * lock time.
+ */
+static void time_retime(hwsys_phase_t phase, U32 cclk, U32 pclk) {
+    U32 cpsr, rate, rest;
+    U64 t, s;
+
+    if(phase != HWSYS_FREQ_POST || time_rate == 0) return;
+
+    cpsr = irq_fiq_save();
+    DISABLE_TIMER1;
+
+    t = time_now_cycles();
+    if(pclk % time_rate == 0) {
+        rate = time_rate;
+        SET_PRESCALE1(pclk / time_rate - 1);
+    } else {
+        rate = pclk / (T1PR + 1);
+        s    = t / time_rate;
+        rest = (U32) (t - s * time_rate);
+        t    = s * rate + ((U64) rest * rate) / time_rate;
+    }
+
+    // a TC written at the top raises no flag: the reader
+    // would take it for a counted wrap
+    if((U32) t == 0xFFFFFFFF) --t;
+
+    T1PC      = 0;
+    T1TC      = (U32) t;
+    T1IR      = TIME_WRAP_IR;
+    time_hi   = (U32) (t >> 32);
+    time_rate = rate;
+
+    ENABLE_TIMER1;
+    irq_restore(cpsr);
+}
+
+/*
+ * time_running
+ * ------------------------------
+ */
+bool time_running(void) {
+    return (time_rate != 0) ? TRUE : FALSE;
+}
+
+/*
+ * time_hz
+ * ------------------------------
+ */
+U32 time_hz(void) {
+    return time_rate;
+}
+
+/*
+ * time_now_cycles
+ * ------------------------------
+ * With the MR3 flag up the wrap is not counted yet: it
+ * has happened if lo is past it (the flag can be raised
+ * after TC was read, so a lo at the top has not). With
+ * the flag down and TC still at 0xFFFFFFFF, TIMER1_Wrap
+ * has counted it early.
+ */
+U64 time_now_cycles(void) {
+    U32 cpsr, hi, lo;
+
+    cpsr = irq_fiq_save();
+    hi = time_hi;
+    lo = T1TC;
+    if(T1IR & TIME_WRAP_IR) {
+        if(lo < 0x80000000) ++hi;
+    } else if(lo == 0xFFFFFFFF) {
+        --hi;
+    }
+    irq_restore(cpsr);
+
+    return ((U64) hi << 32) | lo;
+}
+
+/*
+ * time_now_us
+ * ------------------------------
+ * Whole seconds and the rest apart, so ticks * 10^6
+ * cannot overflow.
+ */
+U64 time_now_us(void) {
+    U64 t, s;
+    U32 rest;
+
+    if(time_rate == 0) return 0;
+
+    t    = time_now_cycles();
+    s    = t / time_rate;
+    rest = (U32) (t - s * time_rate);
+
+    return s * 1000000 + ((U64) rest * 1000000) / time_rate;
+}
+
+/*
+ * delay_ticks
+ * ------------------------------
+ * ticks time base ticks, calling yield while waiting.
+ * The callers round up and the tick in progress does
+ * not count: at least the time asked for, at any rate.
+ */
+static void delay_ticks(U64 ticks, void (*yield)(void)) {
+    U64 end;
+
+    end = time_now_cycles() + ticks + 1;
+    while(time_now_cycles() < end) {
+        if(yield) yield();
+    }
+}
+
+/*
+ * delay_us
+ * ------------------------------
+ */
+void delay_us(U32 us) {
+    if(time_rate == 0) time_init(0);
+
+    delay_ticks(((U64) us * time_rate + 999999) / 1000000, 0);
+}
+
+/*
+ * delay_ms
+ * ------------------------------
+ */
+void delay_ms(U32 ms) {
+    if(time_rate == 0) time_init(0);
+
+    delay_ticks(((U64) ms * time_rate + 999) / 1000, 0);
+}
+
+/*
+ * delay_ms_yield
+ * ------------------------------
+ */
+void delay_ms_yield(U32 ms, void (*yield)(void)) {
+    if(time_rate == 0) time_init(0);
+
+    delay_ticks(((U64) ms * time_rate + 999) / 1000, yield);
+}
@@ -0,0 +1,650 @@
+
+/*
+ * lpc-uart.c
+ * -------------------------------------------
+ * Port generic UART driver. Every port gets the
+ * same polled, FIFO burst and interrupt driven
+ * paths; conio.c keeps the old console names.
+ */
+
+#include "./include/lpc-uart.h"
+
+#include "types.h"
+#include "lpc214x.h"
+#include "hwsys.h"
+#include "helpers.h"
+#include "interrupts.h"
+#include "lpc-timer.h"
+
+#define TXBUF_MASK           (UART_TXBUF_SIZE - 1)
+#define RXBUF_MASK           (UART_RXBUF_SIZE - 1)
+
+// cycles per empty poll in uart_getline_nb, a rough
+// guess used to turn timeout_ms into a poll count
+// when the time base is not running.
+#define RX_POLL_CYCLES       40
+
+// uart_baud_solve error for a rate it cannot get near
+#define BAUD_ERR_NONE        0xFFFF
+
+/*
+ * What differs between the ports besides the
+ * register block.
+ */
+typedef struct {
+    U32   pconp;                  // PCONP power bit
+    U32   pinsel0_mask;           // PINSEL0 bits for TXD/RXD
+    U32   pinsel0_val;
+    U32   pinsel1_mask;           // PINSEL1 bits for TXD/RXD
+    U32   pinsel1_val;
+    U8    vic_channel;
+    void  (*handler)(void);
+} uart_desc_t;
+
+#ifdef LPC23xx
+static const uart_desc_t uart_desc[UART_NPORTS] = {
+    // P0.2 TXD0, P0.3 RXD0
+    { 1 << 3,  0x000000F0, 0x00000050, 0x0, 0x0, 6,  UART0_Handler },
+    // P0.15 TXD1, P0.16 RXD1
+    { 1 << 4,  0xC0000000, 0x40000000, 0x3, 0x1, 7,  UART1_Handler },
+    // P0.10 TXD2, P0.11 RXD2
+    { 1 << 24, 0x00F00000, 0x00500000, 0x0, 0x0, 28, UART2_Handler },
+    // P0.0 TXD3, P0.1 RXD3
+    { 1 << 25, 0x0000000F, 0x0000000A, 0x0, 0x0, 29, UART3_Handler }
+};
+#else
+static const uart_desc_t uart_desc[UART_NPORTS] = {
+    // P0.0 TXD0, P0.1 RXD0
+    { PCUART0, 0x0000000F, 0x00000005, 0x0, 0x0, UART0_CHANNEL, UART0_Handler },
+    // P0.8 TXD1, P0.9 RXD1
+    { PCUART1, 0x000F0000, 0x00050000, 0x0, 0x0, UART1_CHANNEL, UART1_Handler }
+};
+#endif
+
+/*
+ * Per port buffers.
+ * Writers put at tx_head, the ISR takes from tx_tail.
+ * tx_busy is TRUE while the UART owns chars that will
+ * end in a THRE interrupt.
+ * The ISR puts at rx_head, readers take from rx_tail.
+ * Single producer, single consumer: no locking needed.
+ * tx_room is the free THR FIFO space the polled writer
+ * knows about.
+ */
+typedef struct {
+    volatile char     tx_buf[UART_TXBUF_SIZE];
+    volatile U16      tx_head;
+    volatile U16      tx_tail;
+    volatile bool     tx_busy;
+    volatile U32      tx_dropped;
+    bool              tx_buffered;
+    txpolicy_t        tx_policy;
+
+    volatile char     rx_buf[UART_RXBUF_SIZE];
+    volatile U16      rx_head;
+    volatile U16      rx_tail;
+    volatile U32      rx_overruns;
+    bool              rx_buffered;
+
+    bool              isr_installed;
+    U8                tx_room;
+    U32               baud;             // uart_init's, for uart_retime
+} uart_state_t;
+
+static uart_state_t uart_state[UART_NPORTS];
+
+/*
+ * uart_baud_solve
+ * ---------------------------------------
+ * Every MULVAL/DIVADDVAL pair (120 of them) gets the
+ * rounded DL for it; keep the pair with the smallest
+ * error. All terms fit in 32 bits for PCLK <= 60MHz:
+ * pclk * mulval <= 9e8, 16 * dl * (mulval + divaddval) <= 3.1e7.
+ */
+U16 uart_baud_solve(U32 pclk, U32 baud, uart_div_t *div) {
+    U32 mul, add, dl, den, rate, diff, err;
+    U32 best = BAUD_ERR_NONE + 1;
+
+    div->dl        = 1;
+    div->mulval    = 1;
+    div->divaddval = 0;
+    div->baud      = 0;
+    div->err       = BAUD_ERR_NONE;
+
+    // the error below is in baud / 100 units
+    if(baud < UART_BAUD_MIN) return(div->err);
+
+    for(mul = 1; mul <= 15 && best; ++mul) {
+        for(add = 0; add < mul && best; ++add) {
+            den = 16 * baud * (mul + add);
+            dl  = (pclk * mul + den / 2) / den;
+
+            if(dl == 0)      dl = 1;
+            if(dl > 0xFFFF)  dl = 0xFFFF;
+            if(add && dl < 3) continue;
+
+            rate = (pclk * mul + 8 * dl * (mul + add)) / (16 * dl * (mul + add));
+            diff = (rate > baud) ? rate - baud : baud - rate;
+            // 0.01% units without overflowing: diff < 2^25
+            err  = (diff >= baud) ? BAUD_ERR_NONE : (diff * 100) / ((baud + 50) / 100);
+            if(err > BAUD_ERR_NONE) err = BAUD_ERR_NONE;
+
+            if(err < best) {
+                best           = err;
+                div->dl        = dl;
+                div->mulval    = mul;
+                div->divaddval = add;
+                div->baud      = rate;
+                div->err       = err;
+            }
+        }
+    }
+    return(div->err);
+}
+
+static void uart_retime(hwsys_phase_t phase, U32 cclk, U32 pclk);
+
+/*
+ * uart_set_div
+ * ---------------------------------------
+ * Load the divisor latches, LCR as it was.
+ */
+static void uart_set_div(U8 port, uart_div_t *div) {
+    U32 lcr = UART_LCR(port) & ~ULCR_DLAB;
+
+    // Set DLAB to access the divisor latches.
+    UART_LCR(port) = lcr | ULCR_DLAB;
+    UART_DLL(port) = div->dl & 0xFF;
+    UART_DLM(port) = div->dl >> 8;
+    UART_FDR(port) = (div->mulval << 4) | div->divaddval;
+    UART_LCR(port) = lcr;
+}
+
+/*
+ * uart_init
+ * ---------------------------------------
+ * Fix to 8N1 for simplicity.
+ */
+U16 uart_init(U8 port, baud_t baudRate) {
+    const uart_desc_t *d = &uart_desc[port];
+    uart_div_t div;
+
+    uart_baud_solve(hwSysPclkVal(), baudRate, &div);
+
+    PCONP  |= d->pconp;
+    PINSEL0 = (PINSEL0 & ~d->pinsel0_mask) | d->pinsel0_val;
+    PINSEL1 = (PINSEL1 & ~d->pinsel1_mask) | d->pinsel1_val;
+
+    UART_LCR(port) = ULCR_8N1;
+    uart_set_div(port, &div);
+
+    // enable and reset the FIFOs, RX trigger one char
+    UART_FCR(port) = UFCR_FIFO_ENABLE | UFCR_RX_RESET | UFCR_TX_RESET;
+
+    uart_state[port].tx_room = 0;
+    uart_state[port].baud    = baudRate;
+    hwSysFreqNotify(uart_retime);
+
+    return(div.err);
+}
+
+/*
+ * uart_retime
+ * ---------------------------------------
+ * hwSysSetFreq callback for every port uart_init has
+ * set up: before, let the last char leave at the old
+ * rate; after, the divisors for the new PCLK.
+ */
+static void uart_retime(hwsys_phase_t phase, U32 cclk, U32 pclk) {
+    uart_div_t div;
+    U8 port;
+
+    for(port = 0; port < UART_NPORTS; ++port) {
+        if(uart_state[port].baud == 0) continue;
+
+        if(phase == HWSYS_FREQ_PRE) {
+            uart_txflush(port);
+            while(!(UART_LSR(port) & ULSR_TEMT));
+        } else {
+            uart_baud_solve(pclk, uart_state[port].baud, &div);
+            uart_set_div(port, &div);
+        }
+    }
+}
+
+/*
+ * uart_install
+ * ---------------------------------------
+ * Put the port handler in the VIC, once.
+ */
+static void uart_install(U8 port, U16 isr_vec) {
+    uart_state_t *s = &uart_state[port];
+
+    if(s->isr_installed) return;
+
+    enableVIC_INT(uart_desc[port].vic_channel, isr_vec,
+                  (U32) uart_desc[port].handler);
+    s->isr_installed = TRUE;
+}
+
+/*
+ * uart_txbuffer
+ * ---------------------------------------
+ * Polled output may still be in the THR FIFO: it
+ * drains first, so tx_buffered_write can put a whole
+ * FIFO load in.
+ */
+void uart_txbuffer(U8 port, U16 isr_vec, txpolicy_t policy) {
+    uart_state_t *s = &uart_state[port];
+
+    while(!(UART_LSR(port) & ULSR_THRE));
+
+    s->tx_head    = s->tx_tail = 0;
+    s->tx_room    = 0;
+    s->tx_busy    = FALSE;
+    s->tx_dropped = 0;
+    s->tx_policy  = policy;
+
+    uart_install(port, isr_vec);
+
+    s->tx_buffered  = TRUE;
+    UART_IER(port) |= UIER_THRE;
+}
+
+/*
+ * uart_rxbuffer
+ * ---------------------------------------
+ */
+void uart_rxbuffer(U8 port, U16 isr_vec) {
+    uart_state_t *s = &uart_state[port];
+
+    s->rx_head     = s->rx_tail = 0;
+    s->rx_overruns = 0;
+
+    uart_install(port, isr_vec);
+
+    s->rx_buffered  = TRUE;
+    UART_IER(port) |= UIER_RBR | UIER_RLS;
+}
+
+/*
+ * uart_rxoverruns
+ * ---------------------------------------
+ */
+U32 uart_rxoverruns(U8 port) {
+    return(uart_state[port].rx_overruns);
+}
+
+/*
+ * uart_txdropped
+ * ---------------------------------------
+ */
+U32 uart_txdropped(U8 port) {
+    return(uart_state[port].tx_dropped);
+}
+
+/*
+ * tx_poll_fifo
+ * ---------------------------------------
+ * Move up to a FIFO load of queued chars to the UART
+ * by polling THRE. Used when the ISR cannot run
+ * (IRQs disabled). Call with IRQs disabled.
+ */
+static void tx_poll_fifo(U8 port) {
+    uart_state_t *s = &uart_state[port];
+    U16 n;
+
+    if(s->tx_tail == s->tx_head) return;
+
+    while (!(UART_LSR(port) & ULSR_THRE));
+    for(n = 0; n < UART_FIFO_LEN && s->tx_tail != s->tx_head; ++n) {
+        UART_THR(port) = s->tx_buf[s->tx_tail];
+        s->tx_tail     = (s->tx_tail + 1) & TXBUF_MASK;
+    }
+    s->tx_busy = TRUE;
+}
+
+/*
+ * tx_buffered_write
+ * ---------------------------------------
+ * queue len chars for the port ISR.
+ * If the transmitter is idle (ring empty, THR FIFO
+ * empty) up to UART_FIFO_LEN chars go straight to the
+ * THR and the THRE interrupt takes over from there.
+ * Returns the number of chars accepted.
+ */
+static U16 tx_buffered_write(U8 port, const char *buf, U16 len) {
+    uart_state_t *s = &uart_state[port];
+    U32 cpsr;
+    U16 next, n, done = 0;
+
+    cpsr = irq_save();
+
+    while(done < len) {
+        if(!s->tx_busy) {
+            n = MINOF(len - done, UART_FIFO_LEN);
+            while(n--) UART_THR(port) = buf[done++];
+            s->tx_busy = TRUE;
+            continue;
+        }
+
+        next = (s->tx_head + 1) & TXBUF_MASK;
+        if(next == s->tx_tail) {
+            if(s->tx_policy == TX_DROP_NEWEST) {
+                s->tx_dropped += len - done;
+                break;
+            } else if(s->tx_policy == TX_DROP_OLDEST) {
+                s->tx_tail = (s->tx_tail + 1) & TXBUF_MASK;
+                ++s->tx_dropped;
+            } else if(cpsr & IRQ_MASK) {
+                // caller has IRQs off (or is an ISR): nobody else
+                // will drain the buffer, so do it here.
+                tx_poll_fifo(port);
+            } else {
+                // let the ISR in to make room.
+                irq_restore(cpsr);
+                cpsr = irq_save();
+            }
+            continue;
+        }
+
+        s->tx_buf[s->tx_head] = buf[done++];
+        s->tx_head = next;
+    }
+    irq_restore(cpsr);
+
+    return(done);
+}
+
+/*
+ * tx_poll_write
+ * -------------------------------------
+ * Polled burst write: every time THRE shows the
+ * FIFO empty, load up to UART_FIFO_LEN chars.
+ * tx_room remembers how much of the last load is
+ * still free, so single chars (putchar) also fill
+ * the FIFO instead of waiting for THRE each time.
+ */
+static U16 tx_poll_write(U8 port, const char *buf, U16 len) {
+    uart_state_t *s = &uart_state[port];
+    U16 done = 0;
+
+    while(done < len) {
+        if(s->tx_room == 0) {
+            while (!(UART_LSR(port) & ULSR_THRE));
+            s->tx_room = UART_FIFO_LEN;
+        }
+        for( ; s->tx_room && done < len; --s->tx_room) {
+            UART_THR(port) = buf[done++];
+        }
+    }
+    return(done);
+}
+
+/*
+ * uart_txflush
+ * ---------------------------------------
+ * Wait until the ring buffer is empty.
+ */
+void uart_txflush(U8 port) {
+    uart_state_t *s = &uart_state[port];
+    U32 cpsr;
+
+    if(!s->tx_buffered) return;
+
+    cpsr = irq_save();
+    while(s->tx_tail != s->tx_head) {
+        if(cpsr & IRQ_MASK) {
+            tx_poll_fifo(port);
+        } else {
+            irq_restore(cpsr);
+            cpsr = irq_save();
+        }
+    }
+    irq_restore(cpsr);
+}
+
+/*
+ * uart_write
+ * -------------------------------------
+ */
+U16 uart_write(U8 port, const char *buf, U16 len) {
+
+    if(uart_state[port].tx_buffered) return(tx_buffered_write(port, buf, len));
+
+    return(tx_poll_write(port, buf, len));
+}
+
+/*
+ * uart_putchar
+ * -------------------------------------
+ */
+int uart_putchar(U8 port, int ch) {
+    char c = ch;
+
+    if (ch == '\n') uart_write(port, "\r", 1);
+    uart_write(port, &c, 1);
+
+    return ch;
+}
+
+/*
+ * uart_puts
+ * -------------------------------------
+ * Assumes null termination of string.
+ */
+int uart_puts(U8 port, const char *s) {
+    const char *run;
+
+    // send each run of text up to a '\n' as one burst.
+    while(*s) {
+        for(run = s; *s && *s != '\n'; ++s);
+        uart_write(port, run, s - run);
+        if(*s) {
+            uart_write(port, "\r\n", 2);
+            ++s;
+        }
+    }
+    uart_write(port, "\r\n", 2);
+    return(1);
+}
+
+/*
+ * uart_rx_trigger
+ * -------------------------------------
+ * set the RX FIFO trigger level without
+ * resetting the FIFOs.
+ */
+void uart_rx_trigger(U8 port, U8 fcr) {
+
+    UART_FCR(port) = (fcr & UFCR_TRIGGER_MASK) | UFCR_FIFO_ENABLE;
+}
+
+/*
+ * uart_trygetchar
+ * --------------------------------------
+ */
+int uart_trygetchar(U8 port) {
+    uart_state_t *s = &uart_state[port];
+    char ch;
+
+    if (!s->rx_buffered) {
+        if (!(UART_LSR(port) & ULSR_RDR)) return (-1);
+        return ((U8) UART_RBR(port));
+    }
+
+    if (s->rx_tail == s->rx_head) return (-1);
+
+    ch         = s->rx_buf[s->rx_tail];
+    s->rx_tail = (s->rx_tail + 1) & RXBUF_MASK;
+
+    return ((U8) ch);
+}
+
+/*
+ * uart_getchar
+ * --------------------------------------
+ */
+char uart_getchar(U8 port) {
+    int ch;
+
+    while ((ch = uart_trygetchar(port)) < 0);
+
+    return (ch);
+}
+
+/*
+ * line_init
+ * --------------------------------------
+ */
+void line_init(line_t *line, char *buf, U16 size) {
+
+    line->buf      = buf;
+    line->size     = size;
+    line->len      = 0;
+    line->cr       = FALSE;
+    line->overflow = FALSE;
+
+    if (size) buf[0] = '\0';
+}
+
+/*
+ * uart_getline_nb
+ * --------------------------------------
+ */
+int uart_getline_nb(U8 port, line_t *line, U32 timeout_ms) {
+    U64 deadline = 0;
+    U32 polls    = 0;
+    int ch;
+    U16 len;
+
+    if (time_running())
+        deadline = time_now_cycles() + (U64) timeout_ms * (time_hz() / 1000);
+    else
+        polls = timeout_ms * (hwSysCclkVal() / (1000 * RX_POLL_CYCLES));
+
+    while(1) {
+        ch = uart_trygetchar(port);
+        if (ch < 0) {
+            if (deadline) {
+                if (time_now_cycles() >= deadline) return (LINE_PENDING);
+                continue;
+            }
+            if (polls == 0) return (LINE_PENDING);
+            --polls;
+            continue;
+        }
+
+        // second half of a "\r\n" pair.
+        if (ch == '\n' && line->cr) {
+            line->cr = FALSE;
+            continue;
+        }
+        line->cr = (ch == '\r');
+
+        if (ch == '\r' || ch == '\n') {
+            len       = line->len;
+            line->len = 0;
+            if (line->overflow) {
+                line->overflow = FALSE;
+                return (LINE_OVERFLOW);
+            }
+            if (len == 0) continue;
+            line->buf[len] = '\0';
+            return (len);
+        }
+
+        if (line->overflow) continue;
+
+        if (line->len + 1 >= line->size) {
+            line->overflow = TRUE;
+            line->len      = 0;
+            continue;
+        }
+        line->buf[line->len++] = ch;
+    }
+}
+
+/*
+ * uart_service
+ * ---------------------------------------
+ * Service every pending source of one port:
+ *  RLS      - reading LSR clears it, count overruns.
+ *  RDA/CTI  - empty the RX FIFO into the ring buffer.
+ *  THRE     - (cleared by reading IIR) refill the
+ *             16 byte THR FIFO from the ring buffer or
+ *             mark the transmitter idle.
+ * Always inlined into a handler with a constant port,
+ * so the register addresses are constants, and into
+ * RAM with it: it calls nothing.
+ */
+static inline void uart_service(U8 port) __attribute__((always_inline));
+static inline void uart_service(U8 port) {
+    uart_state_t *s = &uart_state[port];
+    U32 iir;
+    U16 next;
+    char ch;
+
+    while(!((iir = UART_IIR(port)) & UIIR_NO_INT)) {
+        switch(iir & UIIR_ID_MASK) {
+            case UIIR_RLS:
+                if(UART_LSR(port) & ULSR_OE) ++s->rx_overruns;
+                break;
+
+            case UIIR_RDA:
+            case UIIR_CTI:
+                while(UART_LSR(port) & ULSR_RDR) {
+                    ch   = UART_RBR(port);
+                    next = (s->rx_head + 1) & RXBUF_MASK;
+                    if(next == s->rx_tail) {
+                        ++s->rx_overruns;
+                    } else {
+                        s->rx_buf[s->rx_head] = ch;
+                        s->rx_head = next;
+                    }
+                }
+                break;
+
+            case UIIR_THRE:
+                // THR FIFO is empty: refill all of it.
+                if(s->tx_tail != s->tx_head) {
+                    for(next = 0; next < UART_FIFO_LEN && s->tx_tail != s->tx_head; ++next) {
+                        UART_THR(port) = s->tx_buf[s->tx_tail];
+                        s->tx_tail     = (s->tx_tail + 1) & TXBUF_MASK;
+                    }
+                } else {
+                    s->tx_busy = FALSE;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/*
+ * UARTn_Handler
+ * ---------------------------------------
+ */
+RAMFUNC void UART0_Handler (void) {
+    uart_service(0);
+    EXIT_INTERRUPT;
+}
+
+RAMFUNC void UART1_Handler (void) {
+    uart_service(1);
+    EXIT_INTERRUPT;
+}
+
+#ifdef LPC23xx
+RAMFUNC void UART2_Handler (void) {
+    uart_service(2);
+    EXIT_INTERRUPT;
+}
+
+RAMFUNC void UART3_Handler (void) {
+    uart_service(3);
+    EXIT_INTERRUPT;
+}
+#endif
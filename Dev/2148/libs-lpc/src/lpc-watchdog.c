@@ -15,14 +15,13 @@
  * Feed the watchdog to run or reload
  */
 void watchdog_feed(void) {
+    U32 cpsr;
 
-// prevent interrupts during feed.
-    disableIRQ();
+// prevent interrupts during feed, IRQ and FIQ as they were after.
+    cpsr = irq_fiq_save();
 
     WDFEED = 0xAA;
     WDFEED = 0x55;
 
-// re-enable interrupts.
-    enableIRQ();
-
+    irq_restore(cpsr);
 }
@@ -6,6 +6,8 @@
 
 #include "./include/olimex.h"
 #include "./include/lpc214x.h"
+#include "./include/lpc-timer.h"
+#include "./include/lpc-gpio.h"
 
 /*
  * enable_leds
@@ -14,10 +16,11 @@
  * These are connected to P0.11 & P0.10
  */
 inline void enable_leds(void) {
+  gpio_init();
   PINSEL0 &= 0xFF3FFFFF;      // GPIO Configuration for  P0.[10,11]
-  IODIR0  |= 0x00000c00;      // P0.11 & P0.10 set to output
   LED1_OFF;
   LED2_OFF;
+  gpio_output(0, 0x00000c00); // P0.11 & P0.10 set to output
 }
 
 /*
@@ -28,7 +31,7 @@ inline void enable_leds(void) {
 void disable_leds(void) {
   LED1_OFF;
   LED2_OFF;
-  IODIR0  &= 0xFFFFF3FF;     // P0.11 & P0.10 set to input
+  gpio_input(0, 0x00000c00); // P0.11 & P0.10 set to input
 
 }
 
@@ -40,17 +43,7 @@ void disable_leds(void) {
  * if it is off, turn it on
  */
 void led1_invert(void) {
-
-    int led;
-    led = IO0PIN;
-
-    led = (0x1) & (led >> 10);
-    if (led == 0x1) { 
-	LED1_ON;
-    }
-    else { 
-	LED1_OFF;
-    }
+    gpio_toggle(0, 1 << LED1_INDEX);
 }
 
 /*
@@ -60,17 +53,7 @@ void led1_invert(void) {
  * if it is off, turn it on
  */
 void led2_invert(void) {
-
-    int led;
-    led = IO0PIN;
-
-    led = (0x1) & (led >> 11);
-    if (led == 0x1) { 
-	LED2_ON;
-    }
-    else { 
-	LED2_OFF;
-    }
+    gpio_toggle(0, 1 << LED2_INDEX);
 }
 
 /* 
@@ -79,7 +62,7 @@ void led2_invert(void) {
  * turn off led1
  */
 inline void led1_off(void) {
-    IOSET0   |= (0x1 << 10);    // turn OFF led 1 (P0.10)
+    FIO0SET   = (0x1 << 10);    // turn OFF led 1 (P0.10)
 }
 
 /*
@@ -88,7 +71,7 @@ inline void led1_off(void) {
  *  turn on led1
  */
 void led1_on(void) {
-    IOCLR0   |= (0x1 << 10);    // turn ON led 1 (P0.10)
+    FIO0CLR   = (0x1 << 10);    // turn ON led 1 (P0.10)
 }
 
 /* 
@@ -97,7 +80,7 @@ void led1_on(void) {
  * turn off led2
  */
 void led2_off(void) {
-    IOSET0   |= (0x1 << 11);    // turn OFF led 2 (P0.11)
+    FIO0SET   = (0x1 << 11);    // turn OFF led 2 (P0.11)
 }
 
 /*
@@ -106,7 +89,7 @@ void led2_off(void) {
  *  turn on led2
  */
 void led2_on(void) {
-    IOCLR0   |= (0x1 << 11);    // turn ON led 1 (P0.11)
+    FIO0CLR   = (0x1 << 11);    // turn ON led 2 (P0.11)
 }
 
 /*
@@ -119,9 +102,9 @@ void flash_led1(int n) {
 
     for(i=0; i<n; ++i) {
 	LED1_ON;
-	waitCount(200000);
+	delay_ms(FLASH_MS);
 	LED1_OFF;
-	waitCount(200000);
+	delay_ms(FLASH_MS);
     }
 }
 
@@ -135,9 +118,9 @@ void flash_led2(int n) {
 
     for(i=0; i<n; ++i) {
 	LED2_ON;
-	waitCount(200000);
+	delay_ms(FLASH_MS);
 	LED2_OFF;
-	waitCount(200000);
+	delay_ms(FLASH_MS);
     }
 }
 
@@ -148,7 +131,7 @@ void flash_led2(int n) {
  */
 void beep_high() {
 
-    beep_custom(800);
+    beep_custom(170);
 
 }
 
@@ -159,34 +142,36 @@ void beep_high() {
  */
 void beep_low() {
 
-    beep_custom(1800);
+    beep_custom(380);
 
 }
 
 /*
  * beep_custom
  * ------------
- * use the buzzer to beep.
+ * use the buzzer to beep, 500 periods of
+ * 2 * halfperiod us.
  */
 void beep_custom(int halfperiod) {
 
-    int savedIODIR0 = IODIR0;   // read IODIR0 and save it in variable
+    U32 out;
+    int k;
 
-    int j, k;
-  
-    IODIR0 |= 0x00003000;      // P0.13 & P0.12 set to output
+    gpio_init();
+    out = FIO0DIR & BUZZER_PINS;    // which buzzer pins were outputs
 
-    IOCLR0 =  0x00003000;      // buzzer:	clear both pins
+    gpio_clr(0, BUZZER_PINS);       // buzzer:	clear both pins
+    gpio_output(0, BUZZER_PINS);    // P0.13 & P0.12 set to output
     k=0;
     while ( k < 500 ) {
 	k +=1;
-	for (j = 0; j < halfperiod; j++ );  
-	IOSET0 = 0x00001000;	             // buzzer
-	for (j = 0; j < halfperiod ; j++ );
-	IOCLR0 = 0x00001000;                 // buzzer
+	delay_us(halfperiod);
+	gpio_set(0, BUZZER_PIN);             // buzzer
+	delay_us(halfperiod);
+	gpio_clr(0, BUZZER_PIN);             // buzzer
     } 
-    IODIR0 = savedIODIR0;       // restore IODIR state
-    waitCount(500000);
+    gpio_input(0, BUZZER_PINS & ~out);   // restore the direction
+    delay_ms(BEEP_GAP_MS);
 }
 
 
@@ -194,6 +179,9 @@ void beep_custom(int halfperiod) {
  * waitCount
  * -----------------------
  * Spin in a loop for count ..
+ * Uncalibrated: the time depends on CCLK and the
+ * compiler flags. delay_us / delay_ms (lpc-timer.h)
+ * are in real time.
  */
 void waitCount(int count) {
     int j;
@@ -18,16 +18,16 @@
  * Reference : User manual LPC214x p38
  */
 void pll0_feed(void) {
-    U32 savedInterrupt;
+    U32 cpsr;
 
-    /* Disable interrupts */
-    savedInterrupt=readAndClearIntEnable();
+    /* Disable interrupts, IRQ and FIQ */
+    cpsr = irq_fiq_save();
 
     PLL0FEED=0xAA;
     PLL0FEED=0x55;
 
     /* restore interrupts */
-    writeIntEnable(savedInterrupt);
+    irq_restore(cpsr);
 }
 
 // pll0_C48_P48 pll0_run(0x1,0x3, 0x01);
@@ -83,6 +83,14 @@ void pll0_run(U8 psel, U8 msel, U8 apbdiv) {
     U8 mselMask   = 0x1f;
     U8 pselMask   = 0x03;
     U8 apbdivMask = 0x03;
+
+    // already running: back on the oscillator before
+    // the multiplier changes (User manual p37)
+    if(PLL0STAT & (0x1<<9)) {
+        PLL0CON=0x1;
+        pll0_feed();
+    }
+
     // set the multiplier and divider values
     PLL0CFG = (0<<7) | ((psel&pselMask)<<5) | (msel&mselMask);
 
@@ -104,6 +112,51 @@ void pll0_run(U8 psel, U8 msel, U8 apbdiv) {
 
 }
 
+static U32 pll_diff(U32 a, U32 b) {
+    return (a > b) ? a - b : b - a;
+}
+
+/*
+ * pll0_solve
+ * ------------------------
+ * 32 x 4 x 3 candidates, integer only.
+ */
+bool pll0_solve(U32 fosc, U32 cclk, U32 pclk, pll_config_t *cfg) {
+    static const U8 apbdivs[3] = { 0x1, 0x2, 0x0 };
+    U32  m, p, a, f, fcco, div, err, best_err = 0;
+    bool found = FALSE;
+
+    for(m = 1; m <= 32; ++m) {
+        f = fosc * m;
+        if(f < PLL_CCLK_MIN || f > PLL_CCLK_MAX) continue;
+
+        // lowest legal Fcco, if any
+        for(p = 0; p < 4; ++p) {
+            fcco = f * 2 * (1 << p);
+            if(fcco >= PLL_FCCO_MIN && fcco <= PLL_FCCO_MAX) break;
+        }
+        if(p == 4) continue;
+
+        for(a = 0; a < 3; ++a) {
+            div = (apbdivs[a] == 0) ? 4 : apbdivs[a];
+            err = pll_diff(f, cclk) + pll_diff(f / div, pclk);
+
+            // m and p only grow: the first of equals is lowest
+            if(found && err >= best_err) continue;
+
+            best_err    = err;
+            found       = TRUE;
+            cfg->msel   = m - 1;
+            cfg->psel   = p;
+            cfg->apbdiv = apbdivs[a];
+            cfg->cclk   = f;
+            cfg->pclk   = f / div;
+            cfg->fcco   = fcco;
+        }
+    }
+    return(found);
+}
+
 /*
  * pll1_feed
  * ----------------------
@@ -112,16 +165,16 @@ void pll0_run(U8 psel, U8 msel, U8 apbdiv) {
  * Reference : User manual LPC214x p38
  */
 void pll1_feed(void) {
-    U32 savedInterrupt;
+    U32 cpsr;
 
-    /* Disable interrupts */
-    savedInterrupt=readAndClearIntEnable();
+    /* Disable interrupts, IRQ and FIQ */
+    cpsr = irq_fiq_save();
 
     PLL1FEED=0xAA;
     PLL1FEED=0x55;
 
     /* restore interrupts */
-    writeIntEnable(savedInterrupt);
+    irq_restore(cpsr);
 }
 
 /*
@@ -18,34 +18,56 @@
 */
 
 /*
-	putchar is the only external dependency for this file,
-	if you have a working putchar, leave it commented out.
-	If not, uncomment the define below and
-	replace outbyte(c) by your own function call.
-#define putchar(c) outbyte(c)
+	Output goes to the UART layer (uart_write in lpc-uart.c), in
+	bursts of up to PRINTF_BUFLEN bytes, or into the caller's
+	buffer for the sprintf family.
 
 */
 
 #include <stdarg.h>
 // #include "console.h"
 #include "conio.h"
+#include "helpers.h"
+#include "lpc-uart.h"
 
+/*
+ * Where print() puts its chars.
+ * port < 0: a string of size bytes (snprintf), chars
+ * past the end are counted but dropped.
+ * port >= 0: a bounce buffer that is handed to
+ * uart_write whenever it fills and at the end, with
+ * '\n' sent as "\r\n" like putchar does.
+ */
+typedef struct {
+	char         *buf;
+	unsigned int  size;
+	unsigned int  pos;
+	unsigned int  count;
+	int           port;
+} out_t;
 
-static void printchar(char **str, int c)
+static void printchar(out_t *out, int c)
 {
-	if (str) {
-		**str = c;
-		++(*str);
+	++out->count;
+
+	if (out->port < 0) {
+		if (out->pos + 1 < out->size)
+			out->buf[out->pos++] = c;
+		return;
 	}
-	else {
-		putchar(c);
+
+	if (c == '\n') printchar (out, '\r'), --out->count;
+	out->buf[out->pos++] = c;
+	if (out->pos == out->size) {
+		uart_write (out->port, out->buf, out->pos);
+		out->pos = 0;
 	}
 }
 
 #define PAD_RIGHT 1
 #define PAD_ZERO 2
 
-static int prints(char **out, const char *string, int width, int pad)
+static int prints(out_t *out, const char *string, int width, int pad)
 {
 	register int pc = 0, padchar = ' ';
 
@@ -75,40 +97,196 @@ static int prints(char **out, const char *string, int width, int pad)
 	return pc;
 }
 
-/* the following should be enough for 32 bit int */
-#define PRINT_BUF_LEN 12
+/*
+ * enough for a 64 bit int in base 8, a sign and '\0';
+ * %f: 20 integer digits, '.', PRINT_FRAC_MAX digits.
+ */
+#define PRINT_BUF_LEN 40
+
+/* most fraction digits %f produces */
+#define PRINT_FRAC_MAX 16
+
+/*
+ * udiv10_64
+ * n / 10 for 64 bit n by shifts and adds
+ * (Hacker's Delight divu10), no __udivdi3.
+ */
+static U64 udiv10_64(U64 n)
+{
+	U64 q, r;
+
+	q = (n >> 1) + (n >> 2);
+	q += q >> 4;
+	q += q >> 8;
+	q += q >> 16;
+	q += q >> 32;
+	q >>= 3;
+	r = n - ((q << 3) + (q << 1));
+	return q + (r > 9);
+}
+
+/*
+ * u64toa
+ * digits of a 64 bit value. Peel decimal digits off
+ * until it fits in 32 bits, then utoa_r does the rest.
+ */
+static int u64toa(U64 u, char *buf, int b)
+{
+	char tmp[21];
+	register char *s = tmp + sizeof(tmp) - 1;
+	register int len, shift;
+	U64 q;
+
+	*s = '\0';
+	if (b == 10) {
+		while (u >> 32) {
+			q = udiv10_64 (u);
+			*--s = '0' + (int)(u - ((q << 3) + (q << 1)));
+			u = q;
+		}
+	}
+	else if (u >> 32) {
+		shift = (b == 16) ? 4 : 3;
+		while (u >> 32) {
+			*--s = "0123456789abcdef"[(int)u & (b - 1)];
+			u >>= shift;
+		}
+	}
+	len = utoa_r ((U32) u, buf, b);
+	/* a leading 0 from utoa_r is not a digit when digits follow */
+	if (*s && (U32) u == 0) len = 0;
+	while ((buf[len] = *s++)) ++len;
+	return len;
+}
+
+/*
+ * printi
+ * digits come from utoa_r (helpers.c), which needs
+ * no division for base 10 and 16; 64 bit values
+ * (%ll) go through u64toa.
+ */
+static int printi(out_t *out, U64 u, int b, int neg, int width, int pad, int letbase)
+{
+	char print_buf[PRINT_BUF_LEN];
+	register char *s, *t;
+	register int pc = 0;
+
+	/* leave room in front for the '-' */
+	s = print_buf + 1;
+	if (u >> 32)
+		u64toa (u, s, b);
+	else
+		utoa_r ((U32) u, s, b);
 
-static int printi(char **out, int i, int b, int sg, int width, int pad, int letbase)
+	if (letbase == 'A') {
+		for (t = s; *t; ++t)
+			if (*t >= 'a') *t += 'A' - 'a';
+	}
+
+	if (neg) {
+		if( width && (pad & PAD_ZERO) ) {
+			printchar (out, '-');
+			++pc;
+			--width;
+		}
+		else {
+			*--s = '-';
+		}
+	}
+
+	return pc + prints (out, s, width, pad);
+}
+
+/*
+ * printf_
+ * %f without floating point code: take the IEEE 754
+ * double apart and produce the digits with integer
+ * shifts and adds. |values| of 2^64 and up print as
+ * "ovf". prec digits after the point (default 6,
+ * at most PRINT_FRAC_MAX), rounded to nearest even.
+ */
+static int printf_(out_t *out, U32 hi, U32 lo, int prec, int width, int pad)
 {
 	char print_buf[PRINT_BUF_LEN];
+	char frac[PRINT_FRAC_MAX];
 	register char *s;
-	register int t, neg = 0, pc = 0;
-	register unsigned int u = i;
+	register int i, pc = 0, neg, e;
+	U64 mant, ipart, f, mask;
 
-	if (i == 0) {
-		print_buf[0] = '0';
-		print_buf[1] = '\0';
-		return prints (out, print_buf, width, pad);
+	neg = hi >> 31;
+	e = (hi >> 20) & 0x7FF;
+	mant = ((U64)(hi & 0xFFFFF) << 32) | lo;
+
+	if (e == 0x7FF)
+		return prints (out, mant ? "nan" : (neg ? "-inf" : "inf"), width, pad & ~PAD_ZERO);
+
+	if (prec < 0) prec = 6;
+	if (prec > PRINT_FRAC_MAX) prec = PRINT_FRAC_MAX;
+
+	if (e == 0) {
+		/* zero or denormal: prints as 0 */
+		mant = 0;
+		e = 1;
 	}
+	else {
+		mant |= (U64)1 << 52;
+	}
+	/* value = mant * 2^e */
+	e -= 1075;
 
-	if (sg && b == 10 && i < 0) {
-		neg = 1;
-		u = -i;
+	if (e >= 0) {
+		if (e > 11)
+			return prints (out, "ovf", width, pad & ~PAD_ZERO);
+		ipart = mant << e;
+		f = 0;
+		e = 1;
 	}
+	else {
+		e = -e;
+		if (e > 60) {
+			/* keep 60 bits of binary fraction, plenty for 16 digits */
+			ipart = 0;
+			mant = (e - 60 >= 64) ? 0 : mant >> (e - 60);
+			e = 60;
+			f = mant;
+		}
+		else {
+			ipart = mant >> e;
+			f = mant & (((U64)1 << e) - 1);
+		}
+	}
+	mask = ((U64)1 << e) - 1;
 
-	s = print_buf + PRINT_BUF_LEN-1;
-	*s = '\0';
+	/* fraction digits: f < 2^60, so f * 10 fits */
+	for (i = 0; i < prec; ++i) {
+		f = (f << 3) + (f << 1);
+		frac[i] = '0' + (int)(f >> e);
+		f &= mask;
+	}
 
-	while (u) {
-		t = u % b;
-		if( t >= 10 )
-			t += letbase - '0' - 10;
-		*--s = t + '0';
-		u /= b;
+	/* round to nearest, ties to even like libc, carrying into the integer part */
+	if (((f >> (e - 1)) & 1) &&
+	    ((f & (mask >> 1)) || (prec ? frac[prec - 1] & 1 : (int) ipart & 1))) {
+		for (i = prec - 1; i >= 0; --i) {
+			if (frac[i] != '9') {
+				++frac[i];
+				break;
+			}
+			frac[i] = '0';
+		}
+		if (i < 0) ++ipart;
+	}
+
+	s = print_buf + 1;
+	i = u64toa (ipart, s, 10);
+	if (prec) {
+		s[i++] = '.';
+		for (e = 0; e < prec; ++e) s[i++] = frac[e];
 	}
+	s[i] = '\0';
 
 	if (neg) {
-		if( width && (pad & PAD_ZERO) ) {
+		if (width && (pad & PAD_ZERO)) {
 			printchar (out, '-');
 			++pc;
 			--width;
@@ -121,16 +299,39 @@ static int printi(char **out, int i, int b, int sg, int width, int pad, int letb
 	return pc + prints (out, s, width, pad);
 }
 
-static int print(char **out, const char *format, va_list args )
+/*
+ * The words of a double as va_arg hands it over.
+ * FPA (the old arm-elf default) stores the high word
+ * first even on little endian; VFP and hosts do not.
+ */
+typedef union {
+	double d;
+	U32    w[2];
+} dbl_t;
+
+#if defined(__arm__) && !defined(__VFP_FP__)
+#define DBL_HI 0
+#define DBL_LO 1
+#else
+#define DBL_HI 1
+#define DBL_LO 0
+#endif
+
+static int print(out_t *out, const char *format, va_list args )
 {
-	register int width, pad;
+	register int width, pad, prec, lng;
 	register int pc = 0;
 	char scr[2];
+	register int c;
+	U64 u;
+	int neg;
+	dbl_t dv;
 
 	for (; *format != 0; ++format) {
 		if (*format == '%') {
 			++format;
-			width = pad = 0;
+			width = pad = lng = 0;
+			prec = -1;
 			if (*format == '\0') break;
 			if (*format == '%') goto out;
 			if (*format == '-') {
@@ -141,32 +342,83 @@ static int print(char **out, const char *format, va_list args )
 				++format;
 				pad |= PAD_ZERO;
 			}
+			if (*format == '*') {
+				++format;
+				width = va_arg( args, int );
+			}
 			for ( ; *format >= '0' && *format <= '9'; ++format) {
 				width *= 10;
 				width += *format - '0';
 			}
-			if( *format == 's' ) {
-				register char *s = (char *)va_arg( args, int );
-				pc += prints (out, s?s:"(null)", width, pad);
-				continue;
+			if (*format == '.') {
+				++format;
+				prec = 0;
+				if (*format == '*') {
+					++format;
+					prec = va_arg( args, int );
+				}
+				for ( ; *format >= '0' && *format <= '9'; ++format) {
+					prec *= 10;
+					prec += *format - '0';
+				}
+			}
+			/* long is 32 bits here, only ll changes anything */
+			while (*format == 'l' || *format == 'h') {
+				if (*format == 'l') ++lng;
+				++format;
 			}
-			if( *format == 'd' ) {
-				pc += printi (out, va_arg( args, int ), 10, 1, width, pad, 'a');
+			c = *format;
+			if( c == 's' ) {
+				register char *s = va_arg( args, char * );
+				if (!s) s = "(null)";
+				if (prec >= 0) {
+					/* print at most prec chars */
+					register int n;
+					for (n = 0; n < prec && s[n]; ++n);
+					if (width > n) width -= n; else width = 0;
+					if (!(pad & PAD_RIGHT))
+						for ( ; width > 0; --width, ++pc) printchar (out, ' ');
+					for ( ; n > 0; --n, ++pc) printchar (out, *s++);
+					for ( ; width > 0; --width, ++pc) printchar (out, ' ');
+				}
+				else {
+					pc += prints (out, s, width, pad);
+				}
 				continue;
 			}
-			if( *format == 'x' ) {
-				pc += printi (out, va_arg( args, int ), 16, 0, width, pad, 'a');
+			if( c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'o' ) {
+				neg = 0;
+				if (lng >= 2) {
+					u = va_arg( args, U64 );
+					if ((c == 'd' || c == 'i') && (long long) u < 0) {
+						neg = 1;
+						u = -u;
+					}
+				}
+				else {
+					U32 v = va_arg( args, U32 );
+					if ((c == 'd' || c == 'i') && (int) v < 0) {
+						neg = 1;
+						v = -v;
+					}
+					u = v;
+				}
+				pc += printi (out, u, (c == 'x' || c == 'X') ? 16 : (c == 'o') ? 8 : 10,
+					      neg, width, pad, (c == 'X') ? 'A' : 'a');
 				continue;
 			}
-			if( *format == 'X' ) {
-				pc += printi (out, va_arg( args, int ), 16, 0, width, pad, 'A');
+			if( c == 'p' ) {
+				printchar (out, '0');
+				printchar (out, 'x');
+				pc += 2 + printi (out, (U32) va_arg( args, void * ), 16, 0, 8, PAD_ZERO, 'a');
 				continue;
 			}
-			if( *format == 'u' ) {
-				pc += printi (out, va_arg( args, int ), 10, 0, width, pad, 'a');
+			if( c == 'f' ) {
+				dv.d = va_arg( args, double );
+				pc += printf_ (out, dv.w[DBL_HI], dv.w[DBL_LO], prec, width, pad);
 				continue;
 			}
-			if( *format == 'c' ) {
+			if( c == 'c' ) {
 				/* char are converted to int then pushed on the stack */
 				scr[0] = (char)va_arg( args, int );
 				scr[1] = '\0';
@@ -180,25 +432,69 @@ static int print(char **out, const char *format, va_list args )
 			++pc;
 		}
 	}
-	if (out) **out = '\0';
-	va_end( args );
 	return pc;
 }
 
-int printf(const char *format, ...)
+int vsnprintf(char *buf, size_t size, const char *format, va_list args)
 {
-        va_list args;
-        
-        va_start( args, format );
-        return print( 0, format, args );
+	out_t out;
+
+	out.buf = buf;
+	out.size = size;
+	out.pos = out.count = 0;
+	out.port = -1;
+
+	print( &out, format, args );
+	if (size) buf[out.pos] = '\0';
+	return out.count;
 }
 
-int sprintf(char *out, const char *format, ...)
+int snprintf(char *buf, size_t size, const char *format, ...)
 {
-        va_list args;
-        
-        va_start( args, format );
-        return print( &out, format, args );
+	va_list args;
+	int n;
+
+	va_start( args, format );
+	n = vsnprintf( buf, size, format, args );
+	va_end( args );
+	return n;
+}
+
+int sprintf(char *buf, const char *format, ...)
+{
+	va_list args;
+	int n;
+
+	va_start( args, format );
+	n = vsnprintf( buf, ~0U >> 1, format, args );
+	va_end( args );
+	return n;
+}
+
+int vprintf(const char *format, va_list args)
+{
+	char  buf[PRINTF_BUFLEN];
+	out_t out;
+
+	out.buf = buf;
+	out.size = sizeof(buf);
+	out.pos = out.count = 0;
+	out.port = PRINTF_PORT;
+
+	print( &out, format, args );
+	if (out.pos) uart_write (out.port, buf, out.pos);
+	return out.count;
+}
+
+int printf(const char *format, ...)
+{
+	va_list args;
+	int n;
+
+	va_start( args, format );
+	n = vprintf( format, args );
+	va_end( args );
+	return n;
 }
 
 #ifdef TEST_PRINTF
@@ -232,6 +528,10 @@ int main(void)
 	sprintf(buf, "-3: %04d zero padded\n", -3); printf("%s", buf);
 	sprintf(buf, "-3: %-4d left justif.\n", -3); printf("%s", buf);
 	sprintf(buf, "-3: %4d right justif.\n", -3); printf("%s", buf);
+	printf("%lld %llx = 64 bit\n", -1234567890123LL, 0x123456789abcULL);
+	printf("%f %.2f %8.3f = floats\n", 3.14159, -0.125, 2.5);
+	i = snprintf(buf, 6, "%s", ptr);
+	printf("\"%s\" %d = snprintf\n", buf, i);
 
 	return 0;
 }
@@ -264,6 +564,9 @@ int main(void)
  * -3: -003 zero padded
  * -3: -3   left justif.
  * -3:   -3 right justif.
+ * -1234567890123 123456789abc = 64 bit
+ * 3.141590 -0.12    2.500 = floats
+ * "Hello" 12 = snprintf
  */
 
 #endif
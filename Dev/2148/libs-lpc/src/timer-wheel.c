@@ -0,0 +1,412 @@
+
+/*
+ * timer-wheel.c
+ * -------------------------------------------
+ * Tickless hierarchical timer wheel on timer0,
+ * see timer-wheel.h
+ */
+
+#include "./include/timer-wheel.h"
+
+#include "lpc214x.h"
+#include "types.h"
+#include "hwsys.h"
+#include "interrupts.h"
+#include "lpc-timer.h"
+#include "helpers.h"
+
+// pseudo levels of tw_next
+#define TW_WRAP        TW_LEVELS       // expiries past the TC wrap
+#define TW_NONE        (TW_LEVELS + 1) // the idle interrupt
+
+// every tick up to tw_now has been handled
+static U32          tw_now;
+
+// timer0 ticks per second: TW_HZ unless PCLK is not a
+// multiple of it
+static U32          tw_rate;
+
+static swtimer_t   *tw_wheel[TW_LEVELS][TW_SLOTS];
+static U32          tw_used[TW_LEVELS];         // a bit per non empty slot
+static swtimer_t   *tw_wrap;
+
+// lowest set bit of a power of 2
+static const U8     tw_debruijn[32] = {
+     0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+    31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+};
+
+/*
+ * The helpers are always inlined: tw_run runs from RAM
+ * and must not call flash, timer_start is in flash and
+ * gets its own copies.
+ */
+static inline void tw_link(swtimer_t **head, swtimer_t *t) __attribute__((always_inline));
+static inline void tw_unlink(swtimer_t *t)                 __attribute__((always_inline));
+static inline void tw_insert(swtimer_t *t)                 __attribute__((always_inline));
+static inline U32  tw_next(U8 *level, U8 *slot)            __attribute__((always_inline));
+static inline void tw_arm(U32 d)                           __attribute__((always_inline));
+
+/*
+ * tw_link / tw_unlink
+ * ------------------------------
+ */
+static inline void tw_link(swtimer_t **head, swtimer_t *t) {
+    t->next  = *head;
+    t->pprev = head;
+    if(t->next) t->next->pprev = &t->next;
+    *head = t;
+}
+
+static inline void tw_unlink(swtimer_t *t) {
+    *t->pprev = t->next;
+    if(t->next) t->next->pprev = t->pprev;
+    t->pprev = 0;
+
+    if(t->level < TW_LEVELS && tw_wheel[t->level][t->slot] == 0)
+        tw_used[t->level] &= ~(1 << t->slot);
+}
+
+/*
+ * tw_insert
+ * ------------------------------
+ * Level: the highest 5 bit group where expires and
+ * tw_now differ. Within it the slot is ahead of the
+ * wheel's, the groups above are the wheel's.
+ */
+static inline void tw_insert(swtimer_t *t) {
+    U32 x;
+    U8  l = 0;
+
+    if(t->expires < tw_now) {
+        t->level = TW_WRAP;
+        tw_link(&tw_wrap, t);
+        return;
+    }
+
+    x = t->expires ^ tw_now;
+    while(x >= TW_SLOTS) {
+        x >>= 5;
+        ++l;
+    }
+
+    t->level = l;
+    t->slot  = (t->expires >> (5 * l)) & (TW_SLOTS - 1);
+    tw_link(&tw_wheel[l][t->slot], t);
+    tw_used[l] |= (1 << t->slot);
+}
+
+/*
+ * tw_next
+ * ------------------------------
+ * Ticks from tw_now to the next thing to do, and what:
+ * level 0 expiries, moving a slot of a higher level down,
+ * the wrap list at TC 0 or nothing (TW_IDLE).
+ */
+static inline U32 tw_next(U8 *level, U8 *slot) {
+    U32 best = TW_IDLE, d, m, at, cur;
+    U8  l, s;
+
+    *level = TW_NONE;
+
+    for(l = 0; l < TW_LEVELS; ++l) {
+        if(tw_used[l] == 0) continue;
+
+        // level 0 slots from the current one, the others after it
+        cur = (tw_now >> (5 * l)) & (TW_SLOTS - 1);
+        if(l > 0) ++cur;
+        if(cur >= TW_SLOTS) continue;
+
+        m = tw_used[l] & (0xFFFFFFFF << cur);
+        if(m == 0) continue;
+        s = tw_debruijn[((m & -m) * 0x077CB531) >> 27];
+
+        // the start of slot s with the wheel's higher groups
+        at = (l < TW_LEVELS - 1) ? tw_now & ~((1 << (5 * (l + 1))) - 1) : 0;
+        at |= (U32) s << (5 * l);
+        if(l == 0 || at > tw_now) d = at - tw_now;
+        else                      d = 0;
+
+        if(d < best) {
+            best   = d;
+            *level = l;
+            *slot  = s;
+        }
+    }
+
+    if(tw_wrap) {
+        d = 0 - tw_now;
+        if(d < best) {
+            best   = d;
+            *level = TW_WRAP;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * tw_arm
+ * ------------------------------
+ * MR0 at tw_now + d. If TC is there already the match
+ * is missed until TC wraps: then take it a few ticks on.
+ */
+static inline void tw_arm(U32 d) {
+    U32 at = tw_now + d;
+
+    T0MR0 = at;
+    while((U32) (T0TC - tw_now) >= (U32) (at - tw_now)) {
+        at    = T0TC + 2;
+        T0MR0 = at;
+    }
+}
+
+/*
+ * tw_run
+ * ------------------------------
+ * Do every event up to TC, then arm the next. Runs
+ * from RAM, callbacks are called through t->fn.
+ */
+RAMFUNC static void tw_run(void) {
+    swtimer_t *t, *list;
+    U32 d;
+    U8  level, slot;
+
+    while(1) {
+        d = tw_next(&level, &slot);
+        if(d > (U32) (T0TC - tw_now)) break;
+
+        tw_now += d;
+
+        if(level == TW_NONE) continue;
+
+        if(level == TW_WRAP) {
+            list    = tw_wrap;
+            tw_wrap = 0;
+            while((t = list) != 0) {
+                list = t->next;
+                tw_insert(t);
+            }
+        } else if(level == 0) {
+            // off the wheel first: a callback may start a
+            // timer in this slot index one lap on
+            list = tw_wheel[0][slot];
+            tw_wheel[0][slot] = 0;
+            tw_used[0] &= ~(1 << slot);
+            list->pprev = &list;
+            while((t = list) != 0) {
+                tw_unlink(t);
+                t->fn(t);
+            }
+        } else {
+            list = tw_wheel[level][slot];
+            tw_wheel[level][slot] = 0;
+            tw_used[level] &= ~(1 << slot);
+            while((t = list) != 0) {
+                list = t->next;
+                tw_insert(t);
+            }
+        }
+    }
+
+    tw_arm(d);
+}
+
+/*
+ * TIMER0_Wheel
+ * ------------------------------
+ */
+RAMFUNC static void TIMER0_Wheel(void) __attribute__ ((interrupt("IRQ")));
+RAMFUNC static void TIMER0_Wheel(void) {
+
+    T0IR = 0x1;
+    tw_run();
+
+    EXIT_INTERRUPT;
+}
+
+/*
+ * tw_prescale
+ * ------------------------------
+ * Prescale for pclk: the rate is TW_HZ or above it,
+ * below only for a PCLK under TW_HZ. Sets tw_rate,
+ * returns PR.
+ */
+static U32 tw_prescale(U32 pclk) {
+    U32 pr = (pclk > TW_HZ) ? pclk / TW_HZ - 1 : 0;
+
+    tw_rate = pclk / (pr + 1);
+    return pr;
+}
+
+/*
+ * tw_ticks
+ * ------------------------------
+ * us to ticks of tw_rate, rounded up: a timer never
+ * fires early.
+ */
+static U32 tw_ticks(U32 us) {
+    U64 t;
+
+    if(tw_rate == TW_HZ) return us;
+
+    t = ((U64) us * tw_rate + TW_HZ - 1) / TW_HZ;
+    return (t > TW_MAX_DELAY) ? TW_MAX_DELAY : (U32) t;
+}
+
+/*
+ * tw_retime
+ * ------------------------------
+ * hwSysSetFreq callback: the prescale for the new
+ * PCLK. PC restarts, it could be past the new prescale.
+ * When the rate moves, the time left on every timer
+ * is scaled to it and the wheel rebuilt at TC, as
+ * time_retime scales its count.
+ */
+static void tw_retime(hwsys_phase_t phase, U32 cclk, U32 pclk) {
+    swtimer_t *t, *all = 0;
+    U32 cpsr, old, now, left;
+    U8  l, s;
+
+    if(phase != HWSYS_FREQ_POST) return;
+
+    cpsr = irq_save();
+
+    old = tw_rate;
+    SET_PRESCALE0(tw_prescale(pclk));
+    T0PC = 0;
+
+    if(tw_rate != old) {
+        for(l = 0; l < TW_LEVELS; ++l) {
+            for(s = 0; s < TW_SLOTS; ++s) {
+                while((t = tw_wheel[l][s]) != 0) {
+                    tw_wheel[l][s] = t->next;
+                    t->next = all;
+                    all = t;
+                }
+            }
+            tw_used[l] = 0;
+        }
+        while((t = tw_wrap) != 0) {
+            tw_wrap = t->next;
+            t->next = all;
+            all = t;
+        }
+
+        // due and not run yet: at TC
+        now    = T0TC;
+        tw_now = now;
+        while((t = all) != 0) {
+            all  = t->next;
+            left = t->expires - now;
+            if(left > TW_MAX_DELAY) left = 0;
+            left = (U32) (((U64) left * tw_rate + old - 1) / old);
+            if(left > TW_MAX_DELAY) left = TW_MAX_DELAY;
+            t->expires = now + left;
+            tw_insert(t);
+        }
+
+        tw_arm(tw_next(&l, &s));
+    }
+
+    irq_restore(cpsr);
+}
+
+/*
+ * timer_wheel_init
+ * ------------------------------
+ */
+void timer_wheel_init(void) {
+    U8 l, s;
+
+    disableTIMER0_INT();
+
+    for(l = 0; l < TW_LEVELS; ++l) {
+        for(s = 0; s < TW_SLOTS; ++s) tw_wheel[l][s] = 0;
+        tw_used[l] = 0;
+    }
+    tw_wrap = 0;
+    tw_now  = 0;
+
+    DISABLE_TIMER0;
+    SET_T0CTCR(0x0);
+    SET_PRESCALE0(tw_prescale(hwSysPclkVal()));
+    SET_MATCH_CONTROL_0(0x1);                   // interrupt on MR0
+    RESET_TIMER0;
+    T0MR0 = TW_IDLE;
+    RESET_T0IR;
+
+    irq_attach(TIMER0_CHANNEL, (U32) TIMER0_Wheel, TW_PRIORITY);
+    hwSysFreqNotify(tw_retime);
+
+    ENABLE_TIMER0;
+}
+
+/*
+ * timer_start
+ * ------------------------------
+ */
+void timer_start(swtimer_t *t, U32 delay, swtimer_fn fn) {
+    U32 cpsr, d;
+    U8  level, slot;
+
+    if(delay == 0) delay = 1;
+    if(delay > TW_MAX_DELAY) delay = TW_MAX_DELAY;
+
+    cpsr = irq_save();
+
+    delay = tw_ticks(delay);
+
+    if(t->pprev) tw_unlink(t);
+
+    // nothing due up to TC: move the wheel there, or t
+    // could land in a slot that TC has passed already
+    d = tw_next(&level, &slot);
+    if(d > (U32) (T0TC - tw_now)) tw_now = T0TC;
+
+    t->fn      = fn;
+    t->expires = T0TC + delay;
+    tw_insert(t);
+
+    d = tw_next(&level, &slot);
+    tw_arm(d);
+
+    irq_restore(cpsr);
+}
+
+/*
+ * timer_cancel
+ * ------------------------------
+ * MR0 stays: at worst one interrupt with nothing to do.
+ */
+void timer_cancel(swtimer_t *t) {
+    U32 cpsr;
+
+    cpsr = irq_save();
+    if(t->pprev) tw_unlink(t);
+    irq_restore(cpsr);
+}
+
+/*
+ * timer_pending
+ * ------------------------------
+ */
+bool timer_pending(swtimer_t *t) {
+    return (t->pprev != 0) ? TRUE : FALSE;
+}
+
+/*
+ * timer_now
+ * ------------------------------
+ */
+U32 timer_now(void) {
+    return T0TC;
+}
+
+/*
+ * timer_wheel_hz
+ * ------------------------------
+ */
+U32 timer_wheel_hz(void) {
+    return tw_rate;
+}
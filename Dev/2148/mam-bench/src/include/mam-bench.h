@@ -0,0 +1,36 @@
+
+/*
+ * mam-bench.h
+ */
+
+#ifndef _MAM_BENCH_H
+#define _MAM_BENCH_H
+
+
+#include "types.h"
+#include "lpc214x.h"
+
+// U0LSR: transmitter empty, THR and shift register
+#define LSR_TEMT              0x40
+
+// kernel sizes: words copied, bytes CRCed, FIR taps and outputs
+#define COPY_WORDS            64
+#define CRC_BYTES             256
+#define FIR_TAPS              16
+#define FIR_OUT               32
+
+// flash the tuner's signature is a CRC of: vectors, startup, code
+#define SIG_FLASH_BASE        0x00000000
+#define SIG_FLASH_BYTES       1024
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * initialize the lpc2148 pll
+ * the uart0 serial port
+ * the time base and the bench timer
+ */
+void initialize(void);
+
+
+#endif
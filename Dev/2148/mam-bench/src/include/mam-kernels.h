@@ -0,0 +1,53 @@
+
+/*
+ * mam-kernels.h
+ * -------------------------------------------
+ * The mam-bench kernels. Included once per place
+ * they run from, no include guard:
+ *
+ *   KERNEL(name)   the name of this copy
+ *   KERNEL_ATTR    its attributes, e.g. RAMFUNC
+ */
+
+/*
+ * copy
+ * ------------------------------
+ * n words, the loop memcpy runs on aligned buffers.
+ */
+KERNEL_ATTR static void KERNEL(copy)(U32 *d, const U32 *s, U32 n) {
+    while(n--) *d++ = *s++;
+}
+
+/*
+ * crc32
+ * ------------------------------
+ * Reflected 0xEDB88320, a bit at a time: no table
+ * fetches, only code.
+ */
+KERNEL_ATTR static U32 KERNEL(crc32)(const U8 *p, U32 n) {
+    U32 crc = 0xFFFFFFFF;
+    U32 k;
+
+    while(n--) {
+        crc ^= *p++;
+        for(k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+/*
+ * fir
+ * ------------------------------
+ * FIR_TAPS Q15 taps over FIR_OUT outputs, x holds
+ * FIR_OUT + FIR_TAPS - 1 samples.
+ */
+KERNEL_ATTR static void KERNEL(fir)(short *y, const short *x, const short *h) {
+    int acc;
+    U32 i, k;
+
+    for(i = 0; i < FIR_OUT; ++i) {
+        acc = 0;
+        for(k = 0; k < FIR_TAPS; ++k) acc += (int) h[k] * x[i + k];
+        y[i] = (short) (acc >> 15);
+    }
+}
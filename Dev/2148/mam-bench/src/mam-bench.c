@@ -0,0 +1,233 @@
+/*
+ * mam-bench.c
+ * -------------------------
+ * Cycles per call of small kernels (word copy,
+ * memcpy, snprintf %d, CRC-32, a FIR) at every CCLK
+ * hwSysInit supports, under each MAM mode and each
+ * MAMTIM the datasheet allows, run from flash and
+ * from RAM. Then bench_mam_tune picks the fastest
+ * setting that still reads flash right and leaves
+ * it in place.
+ *
+ * The RAM copies still read the FIR taps through the
+ * MAM. memcpy against memcpy_fast is the flash vs
+ * .fastcode difference for the library's RAMFUNCs.
+ *
+ * 'r' runs it again.
+ */
+
+
+#include "./include/mam-bench.h"
+
+
+#include <string.h>
+
+#include "lpc214x.h"
+#include "types.h"
+#include "olimex.h"
+#include "helpers.h"
+#include "hwsys.h"
+#include "mam.h"
+#include "conio.h"
+#include "interrupts.h"
+#include "lpc-uart.h"
+#include "lpc-timer.h"
+#include "bench.h"
+
+static const freq_t freqs[] = {
+    TWELVE_MHZ, TWENTYFOUR_MHZ, THIRTYSIX_MHZ, FOURTYEIGHT_MHZ, SIXTY_MHZ
+};
+
+// low pass, Q15, sums to ~1.0
+static const short fir_taps[FIR_TAPS] = {
+    -120, -310, -380,  210, 1650, 3720, 5620, 6600,
+    6600, 5620, 3720, 1650,  210, -380, -310, -120
+};
+
+static U32   copy_src[COPY_WORDS];
+static U32   copy_dst[COPY_WORDS];
+static short fir_x[FIR_OUT + FIR_TAPS - 1];
+static short fir_y[FIR_OUT];
+
+static volatile U32 sink;
+
+/*
+ * Kernels
+ * ------------------------------
+ * One copy in flash (.text), one in RAM (.fastcode).
+ * The RAM copies are only called by the RAM benchmarks
+ * below: see RAMFUNC on calls between the two.
+ */
+#define KERNEL(name)    name##_flash
+#define KERNEL_ATTR
+#include "./include/mam-kernels.h"
+#undef  KERNEL
+#undef  KERNEL_ATTR
+
+#define KERNEL(name)    name##_ram
+#define KERNEL_ATTR     RAMFUNC
+#include "./include/mam-kernels.h"
+#undef  KERNEL
+#undef  KERNEL_ATTR
+
+/*
+ * Benchmarks
+ * ------------------------------
+ */
+static void b_copy_flash(U32 arg) {
+    copy_flash(copy_dst, copy_src, arg);
+}
+
+static void b_memcpy(U32 arg) {
+    memcpy(copy_dst, copy_src, arg * 4);
+}
+
+static void b_snprintf_d(U32 arg) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", (int) arg);
+}
+
+static void b_crc32_flash(U32 arg) {
+    sink = crc32_flash((const U8 *) copy_src, arg);
+}
+
+static void b_fir_flash(U32 arg) {
+    fir_flash(fir_y, fir_x, fir_taps);
+}
+
+static void b_memcpy_fast(U32 arg) {
+    memcpy_fast(copy_dst, copy_src, arg * 4);
+}
+
+// called through bench_t.fn, so from flash too
+RAMFUNC static void b_copy_ram(U32 arg) {
+    copy_ram(copy_dst, copy_src, arg);
+}
+
+RAMFUNC static void b_crc32_ram(U32 arg) {
+    sink = crc32_ram((const U8 *) copy_src, arg);
+}
+
+RAMFUNC static void b_fir_ram(U32 arg) {
+    fir_ram(fir_y, fir_x, fir_taps);
+}
+
+// the flash kernels first: the tuner times FLASH_BENCHES
+#define FLASH_BENCHES   5
+
+static const bench_t suite[] = {
+    { "copy 256 bytes, flash",        b_copy_flash,   COPY_WORDS,  100 },
+    { "memcpy 256 bytes",             b_memcpy,       COPY_WORDS,  100 },
+    { "snprintf %d -123456",          b_snprintf_d,   -123456,     100 },
+    { "crc32 256 bytes, flash",       b_crc32_flash,  CRC_BYTES,   10  },
+    { "fir 16x32, flash",             b_fir_flash,    0,           10  },
+    { "memcpy_fast 256 bytes, ram",   b_memcpy_fast,  COPY_WORDS,  100 },
+    { "copy 256 bytes, ram",          b_copy_ram,     COPY_WORDS,  100 },
+    { "crc32 256 bytes, ram",         b_crc32_ram,    CRC_BYTES,   10  },
+    { "fir 16x32, ram",               b_fir_ram,      0,           10  }
+};
+
+/*
+ * flash_sig
+ * ------------------------------
+ * The tuner's check: a CRC of code in flash, read by
+ * code in flash.
+ */
+static U32 flash_sig(void) {
+    return crc32_flash((const U8 *) SIG_FLASH_BASE, SIG_FLASH_BYTES);
+}
+
+/*
+ * set_clock
+ * ------------------------------
+ * Let the UART finish, change CCLK, bring the
+ * console and the timers back at the new rate.
+ */
+static void set_clock(freq_t f) {
+    uart_txflush(0);
+    while(!(U0LSR & LSR_TEMT));
+
+    hwSysInit(f);
+
+    console0Init(ONE_FIFTEEN_TWO_B);
+    time_init(0);
+    bench_init();
+}
+
+/*
+ * run_suite
+ * ------------------------------
+ */
+static void run_suite(void) {
+    U32 i, n = sizeof(suite) / sizeof(suite[0]);
+    U8  mamcr, mamtim, mam;
+
+    for(i = 0; i < sizeof(freqs) / sizeof(freqs[0]); ++i) {
+        set_clock(freqs[i]);
+
+        for(mamcr = 0; mamcr <= 2; ++mamcr) {
+            for(mamtim = hwSysMamtim(hwSysCclkVal()); mamtim <= 7; ++mamtim) {
+                write_MAM(mamcr, mamtim);
+                bench_report(suite, n);
+            }
+        }
+
+        mam = bench_mam_tune(suite, FLASH_BENCHES, flash_sig);
+        printf("\nCCLK %d MHz  tuned: MAMCR %u MAMTIM %u\n",
+               hwSysCclkVal() / 1000000, mam >> 4, mam & 0x7);
+    }
+}
+
+int main() {
+
+    initialize();
+
+    LED1_ON;
+    LED2_OFF;
+    printf("Hello: mam-bench. best of %d\n", BENCH_TRIES);
+
+    run_suite();
+    printf("\ndone. 'r' runs it again\n");
+    LED2_ON;
+
+    while (1) {
+        if(serial_trygetchar() == 'r') {
+            LED2_OFF;
+            run_suite();
+            printf("\ndone.\n");
+            LED2_ON;
+        }
+    }
+
+    return(0);
+}
+
+
+
+/*
+ * initialize
+ * -----------------------------------------------
+ * initialize the lpc2148 pll
+ * the uart0 serial port
+ * the kernels' data, the time base and the bench timer
+ */
+void initialize(void)  {
+    U32 k;
+
+    // PLL and MAM, APBDIV 1: PCLK == CCLK
+    hwSysInit(SIXTY_MHZ);
+
+    // enable the leds
+    enable_leds();
+
+    console0Init(ONE_FIFTEEN_TWO_B);
+
+    for(k = 0; k < COPY_WORDS; ++k) copy_src[k] = k * 0x9E3779B9;
+    for(k = 0; k < FIR_OUT + FIR_TAPS - 1; ++k) fir_x[k] = (short) (copy_src[k] >> 17);
+
+    time_init(0);
+    bench_init();
+
+    // crt.s starts main with IRQ disabled
+    enableIRQ();
+}
@@ -17,6 +17,7 @@
 #include "conio.h"
 #include "olimex.h"
 #include "interrupts.h"
+#include "defer.h"
 
 
 unsigned short int g_bpressed=0;
@@ -96,15 +97,11 @@ int main (void) {
     // Test 4:
     // Read cpsr register
     cpsr_val = q_cpsr();
-    DBG("CPSR Register is: ");
-    DBG( itoa(cpsr_val, 16) );
-    DBG("\n");
+    DBG("CPSR Register is: %x\n", cpsr_val);
 
     // Test 5:
     // Read r0 register
-    DBG("r0 Register is: 0x");
-    DBG( itoa(r0_val, 16) );
-    DBG("\n");
+    DBG("r0 Register is: 0x%x\n", r0_val);
     DBG("Setting r0 Register to 0x42...\n");
     r0_val = q_r0(0x42);
     DBG("r0 Register is now: 0x%x\n",r0_val);
@@ -144,6 +141,10 @@ void initialize(void)  {
     enable_leds();
 
     console0Init(ONE_FIFTEEN_TWO_B);
+    console0RxBuffer(2);                        // use VIC slot 2
+
+    // button messages run after the handlers return
+    defer_init(DEFER_PRIORITY);
 
     // enable the interrupt control register.
     enableEINT0(0, (unsigned) EINT0_Handler );  // use VIC slot 0
@@ -160,10 +161,16 @@ void initialize(void)  {
  */
 void echo_line(void) {
 
-    char* reply = "\necho: ";
-    char* echo;
+    char*  reply = "\necho: ";
+    char   echo[MAXBUFFER];
+    line_t line;
 
-    echo = serial_getline();
+    line_init(&line, echo, sizeof(echo));
+
+    // led1 blinks while we wait: the UART ISR collects the chars.
+    while(serial_getline_nb(&line, 100) <= 0) {
+        led1_invert();
+    }
 
     puts(reply);
     puts(echo);
@@ -171,6 +178,20 @@ void echo_line(void) {
 }
 
 
+/*
+ * button_pressed
+ * -------------------------
+ * Deferred from the EINT handlers: the led
+ * flashes and the message take milliseconds.
+ */
+static void button_pressed(U32 button) {
+
+    if(button == 1) flash_led1(10);
+    else            flash_led2(10);
+
+    printf("Button B%u pressed\n", button);
+}
+
 /*
  * EINT0_Handler
  * -------------------------
@@ -180,8 +201,7 @@ void EINT0_Handler (void) {
 
 //    ISR_ENTRY();
 
-    flash_led2(10);
-    puts("Button B2 pressed\n");
+    defer_post(button_pressed, 2);
     g_bpressed++;
 
     EXTINT      = 0xF;
@@ -198,8 +218,7 @@ void EINT0_Handler (void) {
 void EINT2_Handler (void) {
 //    ISR_ENTRY();
 
-    flash_led1(10);
-    puts("Button B1 pressed\n");
+    defer_post(button_pressed, 1);
     g_bpressed++;
 
     EXTINT      = 0XF;
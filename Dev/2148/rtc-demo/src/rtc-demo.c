@@ -19,6 +19,8 @@
 #include "interrupts.h"
 #include "hwsys.h"
 #include "conio.h"
+#include "irq-stats.h"
+#include "defer.h"
 
 
 int main() {
@@ -54,7 +56,10 @@ int main() {
     //    CIIR = (0x2); // interrupt every minute.
     CIIR = (0x1); // interrupt every second.
 
-    while (1);
+    // 's' prints how long RTC_Handler takes (libs-lpc -DIRQ_STATS)
+    while (1) {
+        if(serial_trygetchar() == 's') irq_stats_dump();
+    }
 
     return(0);
 }
@@ -85,6 +90,12 @@ void initialize(void)  {
     // 48Mhz PCLK, divisor is 0x1a for 115200
     console0Init(ONE_FIFTEEN_TWO_B);
 
+    // timer1 as the clock for irq_stats, before the attach
+    irq_stats_init();
+
+    // the time is printed after RTC_Handler returns
+    defer_init(DEFER_PRIORITY);
+
     // enable the interrupt control register.
     enableRTC_INT(13, (unsigned) RTC_Handler );
 
@@ -92,50 +103,43 @@ void initialize(void)  {
 
 
 /*
- * RTC_Handler
+ * rtc_print
  * ------------------------
- * Code RTC interrupt
+ * Deferred from RTC_Handler, ctime0 is the CTIME0
+ * it read: the time of the tick, not of the print.
  */
-void RTC_Handler (void) {
+static void rtc_print(U32 ctime0) {
     U32 seconds, minutes, hours;
     U32 day, month, year;
 
     U32 dow, dofy;
 
-    DBG("\nTime is: ");
-    seconds = rtc_readSecs();
-    minutes = rtc_readMins();
-    hours = rtc_readHours();
+    seconds = ctime0 & 0x3F;
+    minutes = (ctime0 >> 8) & 0x3F;
+    hours   = (ctime0 >> 16) & 0x1F;
 
     day = rtc_readDom();
     month = rtc_readMonth();
     year = rtc_readYear();
 
-    dow = rtc_readDow();
+    dow     = (ctime0 >> 24) & 0x7;
     dofy= rtc_readDofY();
     //    dofy= CTIME2;
 
-    DBG(itoa(hours,10));
-    DBG(":");
-    DBG(itoa(minutes,10));
-    DBG(":");
-    DBG(itoa(seconds,10));
-    DBG(".\n");
-
-    DBG("Date is: ");
-    DBG(itoa(day,10));
-
-    DBG("-");
-    DBG(itoa(month,10));
-
-    DBG("-");
-    DBG(itoa(year,10));
+    // one call: with -DDBG_BINARY this is a single
+    // 36 byte frame instead of ~70 chars formatted here.
+    DBG("\nTime is: %d:%d:%d.\nDate is: %d-%d-%d : weekday %d : Ordinal day %d",
+        hours, minutes, seconds, day, month, year, dow, dofy);
+}
 
-    DBG(" : weekday ");
-    DBG(itoa(dow,10));
+/*
+ * RTC_Handler
+ * ------------------------
+ * Code RTC interrupt
+ */
+void RTC_Handler (void) {
 
-    DBG(" : Ordinal day ");
-    DBG(itoa(dofy,10));
+    defer_post(rtc_print, CTIME0);
 
     led1_invert();
     led2_invert();
@@ -1,4 +1,3 @@
-
 /*
  * timer-demo.h
  */
@@ -10,28 +9,22 @@
 #include "types.h"
 #include "lpc214x.h"
 
-#define TIMER0_CHANNEL        4
+// led periods, timer wheel ticks (us)
+#define LED1_PERIOD           500000
+#define LED2_PERIOD           330000
+
+// timers besides the leds
+#define LOAD_TIMERS           100
+
 /*
  * initialize
  * -----------------------------------------------
  * initialize the lpc2148 pll 
  * cpu interrupts
  * the uart0 serial port
- * the rtc VIC interrupt
+ * the timer wheel on timer0
  */
 void initialize(void);
 
 
-/*
- * disableTIMER0_INT
- * ------------------------------
- *
- */
-
-
-
-void TIMER0_Handler (void)   __attribute__ ((interrupt("IRQ")));
-
-
-
 #endif
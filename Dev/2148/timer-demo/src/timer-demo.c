@@ -1,6 +1,9 @@
-
 /*
  * timer-demo.c
+ * -------------------------
+ * Software timers on timer0: the leds blink from two
+ * periodic timers and LOAD_TIMERS more count their
+ * expiries, all on the one match register.
  */
 
 
@@ -15,8 +18,43 @@
 #include "hwsys.h"
 #include "conio.h"
 #include "lpc-timer.h"
+#include "irq-stats.h"
+#include "timer-wheel.h"
+
+static swtimer_t    led1_timer;
+static swtimer_t    led2_timer;
+static swtimer_t    load[LOAD_TIMERS];
+
+static volatile U32 load_fired;
+
+/*
+ * led_blink
+ * ------------------------
+ * arg is the led, 1 or 2.
+ */
+static void led_blink(swtimer_t *t) {
+
+    if(t->arg == 1) {
+        led1_invert();
+        timer_start(t, LED1_PERIOD, led_blink);
+    } else {
+        led2_invert();
+        timer_start(t, LED2_PERIOD, led_blink);
+    }
+}
+
+/*
+ * load_tick
+ * ------------------------
+ * arg is the period.
+ */
+static void load_tick(swtimer_t *t) {
+    ++load_fired;
+    timer_start(t, t->arg, load_tick);
+}
 
 int main() {
+    U32 i;
 
     // Initialize the system
     initialize();
@@ -25,20 +63,31 @@ int main() {
     LED2_OFF;
     DBG("Hello: timer-demo. Watch the lights.\n");
 
-    // run in timer mode.
-    SET_T0CTCR(0x0);
-
-    // match at this value and generate an interrupt.
-    T0MR0=0xFFFFFF;
-
-    // generate an interrupt, reset TC 
-    SET_MATCH_CONTROL_0(0x3);
-
-    RESET_TIMER0;
-    
-    ENABLE_TIMER0;
-
-    while (1);
+    led1_timer.arg = 1;
+    led2_timer.arg = 2;
+    timer_start(&led1_timer, LED1_PERIOD, led_blink);
+    timer_start(&led2_timer, LED2_PERIOD, led_blink);
+
+    // periods from 1 ms up, none alike
+    for(i = 0; i < LOAD_TIMERS; ++i) {
+        load[i].arg = 1000 + 37 * i;
+        timer_start(&load[i], load[i].arg, load_tick);
+    }
+
+    // 's' prints the timer0 IRQ latency and run time (libs-lpc -DIRQ_STATS)
+    // 'c' the load timer expiries so far
+    while (1) {
+        switch(serial_trygetchar()) {
+            case 's':
+                irq_stats_dump();
+                break;
+            case 'c':
+                printf("%u expiries of %u timers\n", load_fired, LOAD_TIMERS);
+                break;
+            default:
+                break;
+        }
+    }
 
     return(0);
 
@@ -52,7 +101,7 @@ int main() {
  * initialize the lpc2148 pll 
  * cpu interrupts
  * the uart0 serial port
- * the rtc VIC interrupt
+ * the timer wheel on timer0
  */
 void initialize(void)  {
       // PLL and MAM
@@ -71,24 +120,10 @@ void initialize(void)  {
     // 48Mhz PCLK, divisor is 0x1a for 115200
     console0Init(ONE_FIFTEEN_TWO_B);
 
-    // enable the interrupt control register.
-    enableTIMER0_INT(0x4, (unsigned) TIMER0_Handler );
-
-}
+    // timer1 as the clock for irq_stats, before the attach
+    irq_stats_init();
 
+    // timer0 and its interrupt
+    timer_wheel_init();
 
-/*
- * TIMER0_Handler
- * ------------------------
- * Code TIMER0 interrupt
- */
-void TIMER0_Handler (void) {
-  
-    led1_invert();
-    led2_invert();
- 
-    RESET_T0IR;     // Timer 0 Interrupt flag
-
-    EXIT_INTERRUPT;
 }
-
@@ -11,8 +11,8 @@
 /* Stack Sizes */
 .set  UND_STACK_SIZE, 0x00000004		/* stack for "undefined instruction" interrupts is 4 bytes  */
 .set  ABT_STACK_SIZE, 0x00000004		/* stack for "abort" interrupts is 4 bytes                  */
-.set  FIQ_STACK_SIZE, 0x00000004		/* stack for "FIQ" interrupts  is 4 bytes         			*/
-.set  IRQ_STACK_SIZE, 0X00000004		/* stack for "IRQ" normal interrupts is 4 bytes    			*/
+.set  FIQ_STACK_SIZE, 0x00000080		/* stack for "FIQ" interrupts  is 128 bytes         			*/
+.set  IRQ_STACK_SIZE, 0x00000100		/* stack for "IRQ" normal interrupts is 256 bytes    			*/
 .set  SVC_STACK_SIZE, 0x00000004		/* stack for "SVC" supervisor mode is 4 bytes  				*/
 
 
@@ -95,6 +95,15 @@ Reset_Handler:
                 strlo   R0, [R2], #4
                 blo     1b
 
+				/* copy .fastcode section (RAMFUNC code, Copy from ROM to RAM) */
+                ldr     R1, =_fastcode_load
+                ldr     R2, =_fastcode
+                ldr     R3, =_efastcode
+3:        		cmp     R2, R3
+                ldrlo   R0, [R1], #4
+                strlo   R0, [R2], #4
+                blo     3b
+
 				/* Clear .bss section (Zero init)  */
                 mov     R0, #0
                 ldr     R1, =_bss_start
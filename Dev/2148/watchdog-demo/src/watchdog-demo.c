@@ -13,6 +13,7 @@
 #include "olimex.h"
 #include "interrupts.h"
 #include "hwsys.h"
+#include "lpc-timer.h"
 #include "conio.h"
 #include "lpc-watchdog.h"
 
@@ -41,9 +42,7 @@ int main() {
 	WATCHDOG_CLEAR_TIMEOUT_FLAG;
 
 	// debug info
-	DBG("Reset WDTOF: ");
-	DBG(itoa(WDMOD,16));
-	DBG("\n");
+	DBG("Reset WDTOF: %x\n", WDMOD);
 
     }
     else {
@@ -64,7 +63,7 @@ int main() {
 
     // feed the dog a few times...
     for(i=0; i<4; ++i) {  
-	waitCount(2000000); 
+	delay_ms(1000);
 	DBG("Feed the dog.\n");
 	watchdog_feed(); // copies from timer const to timer.
     }
@@ -0,0 +1,171 @@
+#!/usr/bin/env python
+
+# Decode the binary log frames sent by LOG() / DBG_BINARY
+# (Dev/2148/libs-lpc/src/include/lpc-log.h) back into text.
+#
+# usage: psas_logdecode.py program.out [capture]
+#
+#   program.out  the ELF image that is running on the board; the
+#                format strings live in its .logfmt section.
+#   capture      file or serial device to read (default stdin). Set the
+#                tty up first, e.g.
+#                  stty -F /dev/ttyUSB0 115200 raw
+#
+# Frame: 0xA5 | nargs | id (LE16) | nargs x U32 (LE).
+# Any other bytes are plain text output and are copied through.
+
+import re
+import struct
+import sys
+
+LOG_SYNC    = 0xA5
+LOG_MAXARGS = 8
+
+SHT_PROGBITS = 1
+SHF_ALLOC    = 0x2
+
+
+class Elf:
+    """Just enough ELF reading to find sections by name and address."""
+
+    def __init__(self, path):
+        data = open(path, 'rb').read()
+        if data[:4] != b'\x7fELF':
+            raise ValueError('%s: not an ELF file' % path)
+        is64   = data[4] == 2 if isinstance(data[4], int) else ord(data[4]) == 2
+        endian = '<' if (data[5] if isinstance(data[5], int) else ord(data[5])) == 1 else '>'
+        if is64:
+            shoff, = struct.unpack_from(endian + 'Q', data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', data, 0x3A)
+            fmt = endian + 'IIQQQQIIQQ'
+        else:
+            shoff, = struct.unpack_from(endian + 'I', data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', data, 0x2E)
+            fmt = endian + 'IIIIIIIIII'
+
+        raw = []
+        for i in range(shnum):
+            raw.append(struct.unpack_from(fmt, data, shoff + i * shentsize))
+        strtab = raw[shstrndx]
+        names  = data[strtab[4]:strtab[4] + strtab[5]]
+
+        self.sections = []
+        for (name, stype, flags, addr, offset, size) in (r[:6] for r in raw):
+            end = names.index(b'\0', name)
+            self.sections.append({
+                'name':  names[name:end].decode('ascii'),
+                'type':  stype,
+                'flags': flags,
+                'addr':  addr,
+                'data':  data[offset:offset + size] if stype == SHT_PROGBITS else b'',
+            })
+
+    def section(self, name):
+        for s in self.sections:
+            if s['name'] == name:
+                return s
+        return None
+
+    def cstring(self, addr):
+        """C string at a target address in a loaded section, or None."""
+        for s in self.sections:
+            if not (s['flags'] & SHF_ALLOC) or not s['data']:
+                continue
+            if s['addr'] <= addr < s['addr'] + len(s['data']):
+                off = addr - s['addr']
+                end = s['data'].find(b'\0', off)
+                if end < 0:
+                    end = len(s['data'])
+                return s['data'][off:end].decode('latin-1')
+        return None
+
+
+SPEC = re.compile(r'%([-+ 0#]*)(\*|\d+)?(?:\.(\d+))?(?:hh|h|ll|l)?([diouxXcsp%])')
+
+
+def s32(v):
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+def expand(elf, fmt, args):
+    """printf the way the target would, from raw U32 argument words."""
+    args = list(args)
+
+    def take():
+        return args.pop(0) if args else 0
+
+    def one(m):
+        flags, width, prec, conv = m.groups()
+        if conv == '%':
+            return '%'
+        if width == '*':
+            width = str(s32(take()))
+        spec = '%' + flags + (width or '') + ('.' + prec if prec else '')
+        v = take()
+        if conv in 'di':
+            return (spec + 'd') % s32(v)
+        if conv in 'ouxX':
+            return (spec + conv.replace('u', 'd')) % v
+        if conv == 'c':
+            return (spec + 'c') % chr(v & 0xFF)
+        if conv == 'p':
+            return (spec + 's') % ('0x%08x' % v)
+        s = elf.cstring(v)
+        return (spec + 's') % (s if s is not None else '<0x%08x>' % v)
+
+    return SPEC.sub(one, fmt)
+
+
+def decode(elf, stream, out):
+    logfmt = elf.section('.logfmt')
+    fmts   = logfmt['data'] if logfmt else b''
+    buf    = bytearray()
+
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        buf += chunk
+
+        while buf:
+            if buf[0] != LOG_SYNC:
+                out.write(chr(buf[0]))
+                del buf[0]
+                continue
+            if len(buf) < 2:
+                break
+            nargs = buf[1]
+            if nargs > LOG_MAXARGS:
+                # not a frame after all
+                out.write(chr(buf[0]))
+                del buf[0]
+                continue
+            size = 4 + 4 * nargs
+            if len(buf) < size:
+                break
+            ident, = struct.unpack_from('<H', bytes(buf), 2)
+            args   = struct.unpack_from('<%dI' % nargs, bytes(buf), 4)
+            del buf[:size]
+
+            end = fmts.find(b'\0', ident)
+            if ident >= len(fmts) or end < 0:
+                out.write('<log id 0x%04x: %s>\n' % (ident, ' '.join('%08x' % a for a in args)))
+            else:
+                out.write(expand(elf, fmts[ident:end].decode('latin-1'), args))
+        out.flush()
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write('usage: %s program.out [capture]\n' % argv[0])
+        return 42
+    elf = Elf(argv[1])
+    if elf.section('.logfmt') is None:
+        sys.stderr.write('%s: no .logfmt section (no LOG calls linked?)\n' % argv[1])
+    stream = open(argv[2], 'rb') if len(argv) > 2 else getattr(sys.stdin, 'buffer', sys.stdin)
+    decode(elf, stream, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))